@@ -0,0 +1,78 @@
+#include "byte_stream.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t len = 64 * 1024 * 1024;
+constexpr size_t capacity = 64000;
+
+//! \returns bytes per second for `bytes` transferred in `duration` nanoseconds
+static double rate(const size_t bytes, const int64_t duration) { return bytes * 1e9 / double(duration); }
+
+void benchmark(const size_t chunk_size) {
+    ByteStream stream{capacity};
+    const string chunk(chunk_size, 'x');
+
+    int64_t write_ns = 0, peek_ns = 0, pop_ns = 0;
+    size_t total = 0;
+    size_t checksum = 0;
+
+    while (total < len) {
+        // fill the stream
+        auto t0 = high_resolution_clock::now();
+        size_t filled = 0;
+        while (stream.remaining_capacity() > 0) {
+            filled += stream.write(chunk);
+        }
+        auto t1 = high_resolution_clock::now();
+
+        // peek at everything, one chunk at a time (the stream is a ring, so chunks wrap around)
+        for (size_t offset = 0; offset < filled; offset += chunk_size) {
+            checksum += stream.peek_output(chunk_size).size();
+        }
+        auto t2 = high_resolution_clock::now();
+
+        // drain the stream
+        while (not stream.buffer_empty()) {
+            stream.pop_output(chunk_size);
+        }
+        auto t3 = high_resolution_clock::now();
+
+        // shift the ring so that subsequent rounds straddle the end of the storage
+        stream.write(chunk.substr(0, chunk_size / 3 + 1));
+        stream.pop_output(chunk_size);
+
+        write_ns += duration_cast<nanoseconds>(t1 - t0).count();
+        peek_ns += duration_cast<nanoseconds>(t2 - t1).count();
+        pop_ns += duration_cast<nanoseconds>(t3 - t2).count();
+        total += filled;
+    }
+
+    if (checksum == 0) {
+        throw runtime_error("peek_output returned no bytes");
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "chunk " << setw(6) << chunk_size << " B:  write " << setw(8) << rate(total, write_ns) / 1e9
+         << " GB/s,  peek " << setw(8) << rate(total, peek_ns) / 1e9 << " GB/s,  pop " << setw(8)
+         << rate(total, pop_ns) / 1e9 << " GB/s\n";
+}
+
+int main() {
+    try {
+        for (const size_t chunk_size : {1, 16, 256, 1452, 16384}) {
+            benchmark(chunk_size);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t len = 64 * 1024 * 1024;
+constexpr size_t capacity = 64000;
+constexpr size_t segment_size = 1452;
+constexpr size_t tiny_segment_size = 16;
+
+struct Segment {
+    size_t index;
+    size_t length;
+};
+
+enum class Workload { InOrder, Reversed, Duplicated, RandomOverlap, TinyReversed };
+
+//! \returns the segments (as ranges of the window starting at `base`) that deliver one window of the stream
+static vector<Segment> window_segments(const Workload workload,
+                                      const size_t base,
+                                      const size_t window,
+                                      mt19937 &rd) {
+    const size_t size = workload == Workload::TinyReversed ? tiny_segment_size : segment_size;
+    vector<Segment> segments;
+    for (size_t offset = 0; offset < window; offset += size) {
+        segments.push_back({base + offset, min(size, window - offset)});
+    }
+
+    switch (workload) {
+        case Workload::InOrder:
+            break;
+        case Workload::Reversed:
+        case Workload::TinyReversed:
+            reverse(segments.begin(), segments.end());
+            break;
+        case Workload::Duplicated: {
+            vector<Segment> doubled;
+            for (const auto &seg : segments) {
+                doubled.push_back(seg);
+                doubled.push_back(seg);
+            }
+            segments = move(doubled);
+        } break;
+        case Workload::RandomOverlap: {
+            // random overlapping substrings of the window, then the full cover (in random order) to finish it
+            vector<Segment> random;
+            for (size_t i = 0; i < segments.size(); ++i) {
+                const size_t start = rd() % window;
+                const size_t length = 1 + rd() % min(2 * segment_size, window - start);
+                random.push_back({base + start, length});
+            }
+            shuffle(segments.begin(), segments.end(), rd);
+            random.insert(random.end(), segments.begin(), segments.end());
+            segments = move(random);
+        } break;
+    }
+    return segments;
+}
+
+static const char *workload_name(const Workload workload) {
+    switch (workload) {
+        case Workload::InOrder:
+            return "in-order";
+        case Workload::Reversed:
+            return "reversed";
+        case Workload::Duplicated:
+            return "duplicated";
+        case Workload::RandomOverlap:
+            return "random overlap";
+        case Workload::TinyReversed:
+            return "tiny reversed";
+    }
+    return "unknown";
+}
+
+void benchmark(const Workload workload, const StreamReassembler::Backend backend) {
+    auto rd = get_random_generator();
+
+    string stream(len, 0);
+    generate(stream.begin(), stream.end(), [&] { return rd(); });
+
+    // prepare every substring up front so that only the reassembler is timed
+    vector<pair<string, size_t>> pushes;
+    for (size_t base = 0; base < len; base += capacity) {
+        for (const auto &seg : window_segments(workload, base, min(capacity, len - base), rd)) {
+            pushes.emplace_back(stream.substr(seg.index, seg.length), seg.index);
+        }
+    }
+
+    StreamReassembler reassembler{capacity, backend};
+    string received;
+    received.reserve(len);
+
+    const auto first_time = high_resolution_clock::now();
+
+    for (const auto &[data, index] : pushes) {
+        reassembler.push_substring(data, index, index + data.size() == len);
+        ByteStream &out = reassembler.stream_out();
+        if (not out.buffer_empty()) {
+            const auto received_so_far = received.size();
+            received.resize(received_so_far + out.buffer_size());
+            out.read_into(received.data() + received_so_far, out.buffer_size());
+        }
+    }
+
+    const auto final_time = high_resolution_clock::now();
+
+    if (received != stream or not reassembler.stream_out().eof()) {
+        throw runtime_error(string("reassembled stream does not match for workload: ") + workload_name(workload));
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const auto gigabits_per_second = len * 8.0 / double(duration);
+
+    cout << fixed << setprecision(2);
+    cout << (backend == StreamReassembler::Backend::Bitmap ? "Bitmap      " : "IntervalMap ");
+    cout << "reassembler throughput (" << setw(14) << workload_name(workload) << "): " << setw(7)
+         << gigabits_per_second << " Gbit/s  (" << pushes.size() << " substrings)\n";
+}
+
+int main() {
+    try {
+        for (const auto backend : {StreamReassembler::Backend::IntervalMap, StreamReassembler::Backend::Bitmap}) {
+            for (const auto workload :
+                 {Workload::InOrder,
+                  Workload::Reversed,
+                  Workload::Duplicated,
+                  Workload::RandomOverlap,
+                  Workload::TinyReversed}) {
+                benchmark(workload, backend);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
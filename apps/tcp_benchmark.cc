@@ -1,35 +1,70 @@
+#include "segment_coalescer.hh"
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+//! Deliver the segments of `x` to `y`, splitting super-segments into wire segments on the way,
+//! and merging what arrives in order with `coalescer`, if any
+//! \returns the number of wire segments delivered
+size_t move_segments(TCPConnection &x,
+                     TCPConnection &y,
+                     vector<TCPSegment> &segments,
+                     const bool reorder,
+                     SegmentCoalescer *coalescer = nullptr) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        TCPSegment &seg = x.segments_out().front();
+        if (seg.payload().size() > x.mss()) {
+            for (auto &piece : seg.split(x.mss())) {
+                segments.emplace_back(move(piece));
+            }
+        } else {
+            segments.emplace_back(move(seg));
+        }
         x.segments_out().pop();
     }
     if (reorder) {
-        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
-            y.segment_received(move(*it));
+        reverse(segments.begin(), segments.end());
+    }
+    if (coalescer) {
+        for (auto &seg : segments) {
+            coalescer->push(move(seg));
+        }
+        coalescer->flush();
+        while (not coalescer->segments_out().empty()) {
+            const CoalescedSegment &run = coalescer->segments_out().front();
+            y.segment_received(run.segment, run.more_payload);
+            coalescer->segments_out().pop();
         }
     } else {
-        for (auto it = segments.begin(); it != segments.end(); ++it) {
-            y.segment_received(move(*it));
+        for (auto &seg : segments) {
+            y.segment_received(move(seg));
         }
     }
+    const size_t count = segments.size();
     segments.clear();
+    return count;
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder, const bool delayed_ack, const bool offload = false, const bool coalesce = false) {
     TCPConfig config;
+    config.delayed_ack = delayed_ack;
+    config.segmentation_offload = offload;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -45,6 +80,8 @@ void main_loop(const bool reorder) {
 
     string string_received;
     string_received.reserve(len);
+    size_t data_segments = 0, ack_segments = 0, sent_segments = 0;
+    SegmentCoalescer coalescer;
 
     const auto first_time = high_resolution_clock::now();
 
@@ -66,13 +103,16 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
-        move_segments(y, x, segments, false);
+        sent_segments += x.segments_out().size();
+        data_segments += move_segments(x, y, segments, reorder, coalesce ? &coalescer : nullptr);
+        ack_segments += move_segments(y, x, segments, false);
 
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
         if (available_output > 0) {
-            string_received.append(y.inbound_stream().read(available_output));
+            const auto received_so_far = string_received.size();
+            string_received.resize(received_so_far + available_output);
+            y.inbound_stream().read_into(string_received.data() + received_so_far, available_output);
         }
 
         // time passes
@@ -93,20 +133,265 @@ void main_loop(const bool reorder) {
     const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
 
     const auto gigabits_per_second = len * 8.0 / double(duration);
+    const auto segments_per_second = data_segments * 1e9 / double(duration);
+    const auto cpu_ms_per_gigabyte = double(duration) / 1e6 / (len / 1e9);
+
+    string options;
+    for (const auto &[on, name] : {pair{reorder, "reordering"},
+                                   pair{delayed_ack, "delayed ACKs"},
+                                   pair{offload, "offload"},
+                                   pair{coalesce, "coalescing"}}) {
+        if (on) {
+            options += (options.empty() ? " with " : ", ") + string(name);
+        }
+    }
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << left << setw(66) << "CPU-limited throughput" + options + ":" << right << setw(5) << gigabits_per_second
+         << " Gbit/s  (" << setw(5) << segments_per_second / 1e6 << " M segments/s, " << setw(6) << cpu_ms_per_gigabyte << " ms CPU per GB, " << setw(5) << double(data_segments) / sent_segments
+         << " wire segments per segment sent, " << double(ack_segments) / data_segments << " ACKs per data segment)\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
-int main() {
+//! Parameters of the simulated path for simulated_loop()
+struct PathConfig {
+    uint64_t delay_ms = 25;         //!< one-way propagation delay
+    double loss = 0;                //!< probability that a segment from the sender is lost
+    double bandwidth_mbps = 100;    //!< bottleneck rate, in each direction
+    size_t bytes = 8 * 1024 * 1024;  //!< bytes to transfer
+    bool adaptive_rto = false;       //!< whether the connections estimate their RTO from the RTT
+    bool fast_retransmit = false;    //!< whether the sender retransmits on duplicate acks
+    bool sack = false;               //!< whether the connections negotiate selective acknowledgments
+    size_t capacity = TCPConfig::DEFAULT_CAPACITY;  //!< send and receive capacity of each connection
+    bool window_scaling = false;                    //!< whether the connections negotiate window scaling
+    bool timestamps = false;                        //!< whether the connections negotiate timestamps
+    bool delayed_ack = false;                       //!< whether the receiver delays acknowledgments
+    double queue_ms = 0;     //!< bottleneck queue, in ms at the bottleneck rate (0 for two one-way delays)
+    double pacing_mbps = 0;  //!< fixed pacing rate for the sender (0 for the congestion control's, if any)
+};
+
+//! \brief One direction of a simulated path: a bottleneck with a drop-tail queue
+//! (of one bandwidth-delay product by default), then a fixed propagation delay
+class SimulatedLink {
+    const PathConfig &path_;
+    const double loss_;
+    mt19937 &rd_;
+    double busy_until_ms_ = 0;                   // when the bottleneck finishes with what's queued
+    deque<pair<uint64_t, TCPSegment>> in_flight_{};  // segments and when they arrive, in order
+
+  public:
+    size_t sent = 0;
+    size_t dropped = 0;
+
+    SimulatedLink(const PathConfig &path, const double loss, mt19937 &rd) : path_(path), loss_(loss), rd_(rd) {}
+
+    void send(TCPSegment &&seg, const uint64_t now_ms) {
+        const double bytes_per_ms = path_.bandwidth_mbps * 1e6 / 8 / 1000;
+        const double queue_ms = path_.queue_ms > 0 ? path_.queue_ms : 2.0 * path_.delay_ms;
+        const double start = max(double(now_ms), busy_until_ms_);
+        ++sent;
+        if (start - now_ms > queue_ms or uniform_real_distribution<double>{0, 1}(rd_) < loss_) {
+            ++dropped;
+            return;
+        }
+        busy_until_ms_ = start + (seg.payload().size() + 40) / bytes_per_ms;
+        in_flight_.emplace_back(uint64_t(busy_until_ms_) + path_.delay_ms, move(seg));
+    }
+
+    void deliver(const uint64_t now_ms, TCPConnection &receiver) {
+        while (not in_flight_.empty() and in_flight_.front().first <= now_ms) {
+            receiver.segment_received(move(in_flight_.front().second));
+            in_flight_.pop_front();
+        }
+    }
+};
+
+//! Transfer `path.bytes` over a simulated path in 1 ms steps, and report the goodput in simulated time
+void simulated_loop(const PathConfig &path, const CongestionControl::Algorithm algorithm) {
+    TCPConfig config;
+    config.congestion_control = algorithm;
+    config.adaptive_rto = path.adaptive_rto;
+    config.fast_retransmit = path.fast_retransmit;
+    config.sack = path.sack;
+    config.send_capacity = config.recv_capacity = path.capacity;
+    config.window_scaling = path.window_scaling;
+    config.timestamps = path.timestamps;
+    config.delayed_ack = path.delayed_ack;
+    config.pacing_rate = path.pacing_mbps * 1e6 / 8;
+    TCPConnection x{config}, y{config};
+
+    mt19937 rd{12345};
+    SimulatedLink forward{path, path.loss, rd}, reverse{path, 0, rd};
+
+    string string_to_send(path.bytes, 0);
+    generate(string_to_send.begin(), string_to_send.end(), [&] { return rd(); });
+
+    Buffer bytes_to_send{string(string_to_send)};
+    x.connect();
+    y.end_input_stream();
+
+    bool x_closed = false;
+
+    string string_received;
+    string_received.reserve(path.bytes);
+    size_t data_segments = 0, ack_segments = 0;
+
+    uint64_t now_ms = 0;
+    auto step = [&] {
+        while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
+            bytes_to_send.remove_prefix(x.write(string(bytes_to_send.str().substr(0, want))));
+        }
+        if (bytes_to_send.size() == 0 and not x_closed) {
+            x.end_input_stream();
+            x_closed = true;
+        }
+
+        while (not x.segments_out().empty()) {
+            data_segments += x.segments_out().front().payload().size() > 0;
+            forward.send(move(x.segments_out().front()), now_ms);
+            x.segments_out().pop();
+        }
+        while (not y.segments_out().empty()) {
+            ++ack_segments;
+            reverse.send(move(y.segments_out().front()), now_ms);
+            y.segments_out().pop();
+        }
+        forward.deliver(now_ms, y);
+        reverse.deliver(now_ms, x);
+
+        const auto available_output = y.inbound_stream().buffer_size();
+        if (available_output > 0) {
+            const auto received_so_far = string_received.size();
+            string_received.resize(received_so_far + available_output);
+            y.inbound_stream().read_into(string_received.data() + received_so_far, available_output);
+        }
+
+        x.tick(1);
+        y.tick(1);
+        ++now_ms;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        step();
+        if (not x.active()) {
+            throw runtime_error("the sender gave up after " + to_string(now_ms) + " simulated ms");
+        }
+    }
+    const uint64_t transfer_ms = now_ms;
+    const double acks_per_segment = double(ack_segments) / data_segments;
+
+    if (string_received != string_to_send) {
+        throw runtime_error("strings sent vs. received don't match");
+    }
+
+    const auto megabits_per_second = path.bytes * 8.0 / 1000.0 / double(transfer_ms);
+
+    cout << fixed << setprecision(2);
+    cout << "Goodput (" << setw(7) << (algorithm == CongestionControl::Algorithm::None
+                                           ? "none"
+                                           : CongestionControl::make(algorithm, 1)->name())
+         << ", " << path.delay_ms << " ms one-way, " << path.loss * 100 << "% loss, " << path.bandwidth_mbps
+         << " Mbit/s): " << setw(8) << megabits_per_second << " Mbit/s  (" << transfer_ms << " ms, " << forward.dropped
+         << " segments dropped (" << 100.0 * forward.dropped / forward.sent << "%), " << x.fast_retransmissions()
+         << " fast and "
+         << x.timeout_retransmissions() << " timeout retransmissions, " << acks_per_segment
+         << " ACKs per data segment)\n";
+
+    while (x.active() or y.active()) {
+        step();
+    }
+}
+
+static void show_usage(const char *argv0) {
+    cerr << "Usage: " << argv0
+         << " [-d <delay_ms>] [-l <loss>] [-b <Mbit/s>] [-n <bytes>] [-C <algo>] [-r fixed|adaptive]\n"
+         << "       [-f on|off] [-s on|off] [-c <bytes>] [-w on|off] [-t on|off] [-a on|off]\n"
+         << "       [-q <queue_ms>] [-p <Mbit/s>]\n\n"
+         << "   With no options, measure CPU-limited throughput over a perfect in-memory path\n"
+         << "   (with and without segmentation offload and receive coalescing).\n"
+         << "   Otherwise, measure goodput over a simulated path with the given one-way delay,\n"
+         << "   loss rate (0..1, sender to receiver), and bottleneck bandwidth, for congestion\n"
+         << "   control <algo> (none, newreno, cubic, bbr) or, by default, for each of them.\n"
+         << "   -r chooses a fixed (the default) or RTT-based retransmission timeout, and -f\n"
+         << "   turns fast retransmit on duplicate acks on or off (the default), and -s SACK.\n"
+         << "   -c sets the send and receive capacity, -w turns window scaling on or off,\n"
+         << "   -t timestamps, and -a delayed acknowledgments. -q sets the bottleneck queue\n"
+         << "   (by default, two one-way delays' worth), and -p paces the sender at a fixed rate.\n";
+}
+
+int main(int argc, char **argv) {
     try {
-        main_loop(false);
-        main_loop(true);
+        if (argc == 1) {
+            for (const bool delayed_ack : {false, true}) {
+                main_loop(false, delayed_ack);
+                main_loop(true, delayed_ack);
+            }
+            // super-segments, split into wire segments only on their way to the peer, and those
+            // merged again before the receiver sees them
+            for (const bool delayed_ack : {false, true}) {
+                main_loop(false, delayed_ack, true);
+                main_loop(false, delayed_ack, false, true);
+                main_loop(false, delayed_ack, true, true);
+            }
+            return EXIT_SUCCESS;
+        }
+
+        PathConfig path;
+        optional<CongestionControl::Algorithm> algorithm;
+        for (int i = 1; i < argc; i += 2) {
+            if (i + 1 == argc) {
+                show_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            const char *arg = argv[i + 1];
+            if (strcmp(argv[i], "-d") == 0) {
+                path.delay_ms = strtoul(arg, nullptr, 0);
+            } else if (strcmp(argv[i], "-l") == 0) {
+                path.loss = strtod(arg, nullptr);
+            } else if (strcmp(argv[i], "-b") == 0) {
+                path.bandwidth_mbps = strtod(arg, nullptr);
+            } else if (strcmp(argv[i], "-n") == 0) {
+                path.bytes = strtoul(arg, nullptr, 0);
+            } else if (strcmp(argv[i], "-r") == 0 and (strcmp(arg, "fixed") == 0 or strcmp(arg, "adaptive") == 0)) {
+                path.adaptive_rto = strcmp(arg, "adaptive") == 0;
+            } else if (strcmp(argv[i], "-f") == 0 and (strcmp(arg, "on") == 0 or strcmp(arg, "off") == 0)) {
+                path.fast_retransmit = strcmp(arg, "on") == 0;
+            } else if (strcmp(argv[i], "-s") == 0 and (strcmp(arg, "on") == 0 or strcmp(arg, "off") == 0)) {
+                path.sack = strcmp(arg, "on") == 0;
+            } else if (strcmp(argv[i], "-c") == 0) {
+                path.capacity = strtoul(arg, nullptr, 0);
+            } else if (strcmp(argv[i], "-w") == 0 and (strcmp(arg, "on") == 0 or strcmp(arg, "off") == 0)) {
+                path.window_scaling = strcmp(arg, "on") == 0;
+            } else if (strcmp(argv[i], "-t") == 0 and (strcmp(arg, "on") == 0 or strcmp(arg, "off") == 0)) {
+                path.timestamps = strcmp(arg, "on") == 0;
+            } else if (strcmp(argv[i], "-a") == 0 and (strcmp(arg, "on") == 0 or strcmp(arg, "off") == 0)) {
+                path.delayed_ack = strcmp(arg, "on") == 0;
+            } else if (strcmp(argv[i], "-q") == 0) {
+                path.queue_ms = strtod(arg, nullptr);
+            } else if (strcmp(argv[i], "-p") == 0) {
+                path.pacing_mbps = strtod(arg, nullptr);
+            } else if (strcmp(argv[i], "-C") == 0) {
+                algorithm = CongestionControl::algorithm_from_name(arg);
+            } else {
+                show_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (algorithm.has_value()) {
+            simulated_loop(path, algorithm.value());
+        } else {
+            for (const auto cc : {CongestionControl::Algorithm::None,
+                                  CongestionControl::Algorithm::NewReno,
+                                  CongestionControl::Algorithm::Cubic,
+                                  CongestionControl::Algorithm::Bbr}) {
+                simulated_loop(path, cc);
+            }
+        }
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -0,0 +1,149 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "timer_wheel.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t connection_count = 10'000;
+constexpr uint64_t tick_ms = 10;          // as in TCPSpongeSocket's event loop
+constexpr uint64_t duration_ms = 60'000;  // a minute of simulated time
+constexpr size_t rounds = duration_ms / tick_ms;
+
+//! Deliver the segments of `from` to `to`
+static void deliver(TCPConnection &from, TCPConnection &to) {
+    while (not from.segments_out().empty()) {
+        to.segment_received(from.segments_out().front());
+        from.segments_out().pop();
+    }
+}
+
+//! Discard the segments of `conn` (they are lost, or nobody is listening)
+static void drop(TCPConnection &conn) {
+    while (not conn.segments_out().empty()) {
+        conn.segments_out().pop();
+    }
+}
+
+//! `connection_count` connections, in established pairs; `busy` of them have sent data
+//! that was lost, so their retransmission timers are running (and will keep firing)
+static vector<TCPConnection> make_connections(const size_t busy) {
+    vector<TCPConnection> connections;
+    connections.reserve(connection_count);
+    for (size_t i = 0; i < connection_count; i += 2) {
+        connections.emplace_back(TCPConfig{});
+        connections.emplace_back(TCPConfig{});
+        TCPConnection &client = connections[i];
+        TCPConnection &server = connections[i + 1];
+        client.connect();
+        deliver(client, server);
+        deliver(server, client);
+        deliver(client, server);
+    }
+    for (size_t i = 0; i < busy; ++i) {
+        TCPConnection &conn = connections[i * (connection_count / busy)];
+        conn.write("lost");
+        drop(conn);
+    }
+    return connections;
+}
+
+//! Reset every connection, so that none of them complains about an unclean shutdown
+static size_t tear_down(vector<TCPConnection> &connections) {
+    size_t retransmissions = 0;
+    TCPSegment rst;
+    rst.header().rst = true;
+    for (auto &conn : connections) {
+        retransmissions += conn.timeout_retransmissions();
+        conn.segment_received(rst);
+    }
+    return retransmissions;
+}
+
+static void report(const string &name,
+                   const size_t busy,
+                   const nanoseconds elapsed,
+                   const size_t ticks,
+                   const size_t retransmissions) {
+    cout << fixed << setprecision(2);
+    cout << setw(5) << name << ", " << setw(3) << busy << " of " << connection_count
+         << " connections retransmitting: " << setw(8) << double(elapsed.count()) / rounds / 1000
+         << " us per " << tick_ms << " ms round, " << setw(10) << double(ticks) / rounds
+         << " connection ticks per round (" << retransmissions << " retransmissions)\n";
+}
+
+//! The event loop's way: tick every connection every round
+static void benchmark_tick_all(const size_t busy) {
+    auto connections = make_connections(busy);
+    size_t ticks = 0;
+
+    const auto first_time = high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (auto &conn : connections) {
+            conn.tick(tick_ms);
+            drop(conn);
+            ++ticks;
+        }
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    report("tick", busy, final_time - first_time, ticks, tear_down(connections));
+}
+
+//! Keep each connection's next timeout in a shared wheel, and tick a connection only when it comes due
+static void benchmark_wheel(const size_t busy) {
+    auto connections = make_connections(busy);
+    vector<uint64_t> last_tick(connections.size(), 0);
+    TimerWheel wheel;
+    size_t ticks = 0;
+
+    // scheduling the deadlines is part of the cost
+    const auto first_time = high_resolution_clock::now();
+    function<void(size_t)> arm = [&](const size_t i) {
+        const auto timeout = connections[i].next_timeout();
+        if (timeout.has_value()) {
+            wheel.schedule(wheel.now() + timeout.value(), [&, i] {
+                // a late tick catches the connection up on all the time since its last one
+                connections[i].tick(wheel.now() - last_tick[i]);
+                last_tick[i] = wheel.now();
+                drop(connections[i]);
+                ++ticks;
+                arm(i);
+            });
+        }
+    };
+    for (size_t i = 0; i < connections.size(); ++i) {
+        arm(i);
+    }
+    for (size_t round = 0; round < rounds; ++round) {
+        wheel.tick(tick_ms);
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    report("wheel", busy, final_time - first_time, ticks, tear_down(connections));
+}
+
+int main() {
+    try {
+        // all idle, then one connection in a hundred with a retransmission timer running
+        for (const size_t busy : {size_t{0}, connection_count / 100}) {
+            benchmark_tick_all(busy);
+            benchmark_wheel(busy);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -10,9 +10,13 @@ add_test(NAME t_wrapping_ints_roundtrip   COMMAND wrapping_integers_roundtrip)
 add_test(NAME t_recv_connect         COMMAND recv_connect)
 add_test(NAME t_recv_transmit        COMMAND recv_transmit)
 add_test(NAME t_recv_window          COMMAND recv_window)
+add_test(NAME t_recv_budget          COMMAND recv_budget)
+add_test(NAME t_recv_sack            COMMAND recv_sack)
+add_test(NAME t_send_sack            COMMAND send_sack)
 add_test(NAME t_recv_reorder         COMMAND recv_reorder)
 add_test(NAME t_recv_close           COMMAND recv_close)
 add_test(NAME t_recv_special         COMMAND recv_special)
+add_test(NAME t_recv_allocations     COMMAND recv_allocations)
 
 add_test(NAME t_send_connect         COMMAND send_connect)
 add_test(NAME t_send_transmit        COMMAND send_transmit)
@@ -21,6 +25,10 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_congestion      COMMAND send_congestion)
+add_test(NAME t_send_rto             COMMAND send_rto)
+add_test(NAME t_send_pacing          COMMAND send_pacing)
+add_test(NAME t_send_offload         COMMAND send_offload)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -30,21 +38,42 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_fast_path   COMMAND fsm_stream_reassembler_fast_path)
+add_test(NAME t_strm_reassem_budget      COMMAND fsm_stream_reassembler_budget)
+
+add_test(NAME t_strm_reassem_single_bitmap      COMMAND fsm_stream_reassembler_single_bitmap)
+add_test(NAME t_strm_reassem_seq_bitmap         COMMAND fsm_stream_reassembler_seq_bitmap)
+add_test(NAME t_strm_reassem_dup_bitmap         COMMAND fsm_stream_reassembler_dup_bitmap)
+add_test(NAME t_strm_reassem_holes_bitmap       COMMAND fsm_stream_reassembler_holes_bitmap)
+add_test(NAME t_strm_reassem_many_bitmap        COMMAND fsm_stream_reassembler_many_bitmap)
+add_test(NAME t_strm_reassem_overlapping_bitmap COMMAND fsm_stream_reassembler_overlapping_bitmap)
+add_test(NAME t_strm_reassem_win_bitmap         COMMAND fsm_stream_reassembler_win_bitmap)
+add_test(NAME t_strm_reassem_cap_bitmap         COMMAND fsm_stream_reassembler_cap_bitmap)
+add_test(NAME t_strm_reassem_fast_path_bitmap   COMMAND fsm_stream_reassembler_fast_path_bitmap)
+add_test(NAME t_strm_reassem_budget_bitmap      COMMAND fsm_stream_reassembler_budget_bitmap)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_peek_views   COMMAND byte_stream_peek_views)
+add_test(NAME t_byte_stream_chunked      COMMAND byte_stream_chunked)
+add_test(NAME t_byte_stream_scatter_gather COMMAND byte_stream_scatter_gather)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
 add_test(NAME arp_network_interface    COMMAND net_interface)
 
+add_test(NAME t_timer_wheel          COMMAND timer_wheel)
+add_test(NAME t_segment_coalescer    COMMAND segment_coalescer)
+add_test(NAME t_segment_refcounts    COMMAND segment_refcounts)
+
 add_test(NAME router_test    COMMAND network_simulator)
 
 add_test(NAME t_tcp_parser           COMMAND tcp_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
 add_test(NAME t_ipv4_parser          COMMAND ipv4_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
+add_test(NAME t_tcp_over_ip          COMMAND tcp_over_ip)
 add_test(NAME t_active_close         COMMAND fsm_active_close)
 add_test(NAME t_passive_close        COMMAND fsm_passive_close)
 add_test(NAME t_ack_rst              COMMAND fsm_ack_rst_relaxed)
@@ -52,9 +81,14 @@ add_test(NAME t_ack_rst_win          COMMAND fsm_ack_rst_win_relaxed)
 add_test(NAME t_connect              COMMAND fsm_connect_relaxed)
 add_test(NAME t_listen               COMMAND fsm_listen_relaxed)
 add_test(NAME t_winsize              COMMAND fsm_winsize)
+add_test(NAME t_winscale             COMMAND fsm_winscale)
+add_test(NAME t_timestamps           COMMAND fsm_timestamps)
+add_test(NAME t_delayed_ack          COMMAND fsm_delayed_ack)
+add_test(NAME t_nagle                COMMAND fsm_nagle)
 add_test(NAME t_retx                 COMMAND fsm_retx_relaxed)
 add_test(NAME t_retx_win             COMMAND fsm_retx_win)
 add_test(NAME t_loopback             COMMAND fsm_loopback)
+add_test(NAME t_fast_retx            COMMAND fsm_fast_retx)
 add_test(NAME t_loopback_win         COMMAND fsm_loopback_win)
 add_test(NAME t_reorder              COMMAND fsm_reorder)
 
@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
@@ -13,40 +16,175 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : capacity_(capacity), size_(0), buffer_(capacity, ' '), begin_(0), input_ended_(false), bytes_w_(0), bytes_r_(0) {}
+//! \returns the smallest power of two that is at least `n` (and at least 1)
+static size_t round_up_pow2(const size_t n) {
+    size_t ret = 1;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
 
-size_t ByteStream::write(const string &data) {
-    size_t res(0);
-    for (auto c: data) {
-        if (size_ < capacity_) {
-	    buffer_[(begin_ + size_) % capacity_] = c;
-	    ++size_;
-	    ++res;
-	    ++bytes_w_;
-	} else break;
+ByteStream::ByteStream(const size_t capacity, const Storage storage)
+    : storage_(storage)
+    , capacity_(capacity)
+    , size_(0)
+    , buffer_()
+    , mask_(0)
+    , begin_(0)
+    , input_ended_(false)
+    , bytes_w_(0)
+    , bytes_r_(0) {}
+
+size_t ByteStream::write(const string &data) { return append(data.data(), data.size()); }
+
+size_t ByteStream::write(const char *data) { return append(data, strlen(data)); }
+
+size_t ByteStream::append(const char *data, const size_t len) {
+    const size_t n = min(len, capacity_ - size_);
+    if (storage_ == Storage::Chunked) {
+        return write(string(data, n));
     }
-    return res;
+    // (the ring has no storage until the first bytes arrive)
+    if (n == 0) {
+        return 0;
+    }
+    grow(size_ + n);
+    const size_t tail = (begin_ + size_) & mask_;
+    const size_t first = min(n, buffer_.size() - tail);
+    memcpy(buffer_.data() + tail, data, first);
+    memcpy(buffer_.data(), data + first, n - first);
+    commit_write(n);
+    return n;
+}
+
+size_t ByteStream::write(string &&data) {
+    if (storage_ == Storage::Ring) {
+        return write(static_cast<const string &>(data));
+    }
+    const size_t len = min(data.size(), capacity_ - size_);
+    if (len == 0) {
+        return 0;
+    }
+    data.resize(len);
+    chunks_.append(Buffer{move(data)});
+    size_ += len;
+    bytes_w_ += len;
+    return len;
+}
+
+size_t ByteStream::write(const BufferViewList &data) {
+    size_t total = 0;
+    for (const auto &iov : data.as_iovecs()) {
+        const size_t n = append(static_cast<const char *>(iov.iov_base), iov.iov_len);
+        total += n;
+        if (n < iov.iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+//! \param[in] len is the maximum number of bytes the caller wants to write
+vector<iovec> ByteStream::writable_iovecs(const size_t len) {
+    vector<iovec> ret;
+    if (storage_ == Storage::Chunked) {
+        return ret;
+    }
+    const size_t n = min(len, capacity_ - size_);
+    if (n == 0) {
+        return ret;
+    }
+    grow(size_ + n);
+    const size_t tail = (begin_ + size_) & mask_;
+    const size_t first = min(n, buffer_.size() - tail);
+    ret.push_back({buffer_.data() + tail, first});
+    if (n > first) {
+        ret.push_back({buffer_.data(), n - first});
+    }
+    return ret;
+}
+
+//! \param[in] len bytes were copied into the space returned by writable_iovecs()
+void ByteStream::commit_write(const size_t len) {
+    if (len > capacity_ - size_) {
+        throw out_of_range("ByteStream::commit_write");
+    }
+    size_ += len;
+    bytes_w_ += len;
+}
+
+void ByteStream::grow(const size_t needed) {
+    if (needed <= buffer_.size()) {
+        return;
+    }
+
+    // at least double, so that a stream filled a little at a time is copied O(log capacity) times
+    vector<char> buffer(min(round_up_pow2(capacity_), max(round_up_pow2(needed), 2 * buffer_.size())));
+    copy_out(buffer.data(), size_);
+    buffer_ = move(buffer);
+    mask_ = buffer_.size() - 1;
+    begin_ = 0;
+}
+
+void ByteStream::copy_out(char *dest, const size_t len) const {
+    if (len == 0) {
+        return;
+    }
+    if (storage_ == Storage::Chunked) {
+        size_t copied = 0;
+        for (auto it = chunks_.buffers().begin(); copied < len; ++it) {
+            const size_t n = min(len - copied, it->size());
+            memcpy(dest + copied, it->str().data(), n);
+            copied += n;
+        }
+        return;
+    }
+    const size_t first = min(len, buffer_.size() - begin_);
+    memcpy(dest, buffer_.data() + begin_, first);
+    memcpy(dest + first, buffer_.data(), len - first);
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
-    std::string res;
-    for (size_t i = 0; i < len; ++i) {
-        if (i + 1 > size_) break;
-	res.push_back(buffer_[(begin_ + i) % capacity_]);
-    }
+    string res(min(len, size_), '\0');
+    copy_out(res.data(), res.size());
     return res;
 }
 
+//! \param[in] len bytes will be exposed from the output side of the buffer
+BufferViewList ByteStream::peek_views(const size_t len) const {
+    const size_t n = min(len, size_);
+    if (storage_ == Storage::Chunked) {
+        BufferViewList views;
+        size_t viewed = 0;
+        for (auto it = chunks_.buffers().begin(); viewed < n; ++it) {
+            const size_t count = min(n - viewed, it->size());
+            views.append(it->str().substr(0, count));
+            viewed += count;
+        }
+        return views;
+    }
+    if (n == 0) {
+        return {};
+    }
+    const size_t first = min(n, buffer_.size() - begin_);
+    BufferViewList views{string_view(buffer_.data() + begin_, first)};
+    if (n > first) {
+        views.append({buffer_.data(), n - first});
+    }
+    return views;
+}
+
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    if (len >= size_) {
-	bytes_r_ += size_; 
-        size_ = 0;
+    const size_t n = min(len, size_);
+    bytes_r_ += n;
+    size_ -= n;
+    if (storage_ == Storage::Chunked) {
+        chunks_.remove_prefix(n);
     } else {
-        bytes_r_ += len;
-	size_ -= len;
-	begin_ = (begin_ + len) % capacity_;
+        begin_ = (begin_ + n) & mask_;
     }
 }
 
@@ -54,19 +192,50 @@ void ByteStream::pop_output(const size_t len) {
 //! \param[in] len bytes will be popped and returned
 //! \returns a string
 std::string ByteStream::read(const size_t len) {
-    std::string res;
-    size_t i = 0;
-    while (i < len) {
-        if (size_ == 0) break;
-	res.push_back(buffer_[(begin_ + i) % capacity_]);
-	--size_;
-	++bytes_r_;
-	++i;
-    }
-    begin_ = (begin_ + i) % capacity_;
+    string res = peek_output(len);
+    pop_output(res.size());
     return res;
 }
 
+//! \param[out] dest receives up to `len` bytes
+//! \param[in] len bytes will be popped
+size_t ByteStream::read_into(char *dest, const size_t len) {
+    const size_t n = min(len, size_);
+    if (n == 0) {
+        return 0;
+    }
+    copy_out(dest, n);
+    pop_output(n);
+    return n;
+}
+
+//! \param[out] str receives up to `len` bytes
+//! \param[in] len bytes will be popped
+size_t ByteStream::read_into(string &str, const size_t len) {
+    str.resize(min(len, size_));
+    return read_into(str.data(), str.size());
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \returns a Buffer holding the bytes
+Buffer ByteStream::read_buffer(const size_t len) {
+    const size_t n = min(len, size_);
+    if (storage_ == Storage::Ring or n == 0 or chunks_.buffers().front().size() < n) {
+        return Buffer{read(n)};
+    }
+    if (chunks_.buffers().front().size() == n) {
+        // the bytes are exactly the first chunk: hand it over rather than share it
+        bytes_r_ += n;
+        size_ -= n;
+        return chunks_.pop_front();
+    }
+    // the bytes are all in the first chunk: hand out a slice of it
+    Buffer slice = chunks_.buffers().front();
+    slice.remove_suffix(slice.size() - n);
+    pop_output(n);
+    return slice;
+}
+
 void ByteStream::end_input() { input_ended_ = true; }
 
 bool ByteStream::input_ended() const { return input_ended_; }
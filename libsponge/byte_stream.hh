@@ -1,7 +1,10 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
 #include <string>
+#include <string_view>
 #include <vector>
 
 //! \brief An in-order byte stream.
@@ -10,6 +13,13 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! How the stream holds bytes between being written and being read
+    enum class Storage {
+        Ring,    //!< copy written bytes into a fixed-size ring (the default)
+        Chunked  //!< keep written strings as refcounted Buffers that can be read out without a copy
+    };
+
   private:
     // Your code here -- add private members as necessary.
 
@@ -18,18 +28,31 @@ class ByteStream {
     // that's a sign that you probably want to keep exploring
     // different approaches.
 
+    Storage storage_;          // which of buffer_ or chunks_ holds the bytes
     size_t capacity_;          // capacity of the stream
     size_t size_;              // size of the buffer
-    std::vector<char> buffer_; // buffer with max capacity of capacity_
+    std::vector<char> buffer_; // ring storage, grown on demand to at most capacity_ rounded up to a power of two
+    size_t mask_;              // buffer_.size() - 1, so that (i & mask_) == (i % buffer_.size())
     size_t begin_;             // circular buffer to be consumed buffer_[begin_, begin_ + size_)
+    BufferList chunks_{};      // written strings, in Storage::Chunked mode
     bool input_ended_;
     size_t bytes_w_;           // bytes written
     size_t bytes_r_;           // bytes read
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
+    //! Make the ring at least `needed` bytes long, keeping its contents
+    void grow(const size_t needed);
+
+    //! Copy the first `len` buffered bytes to `dest` (in at most two contiguous spans of the ring)
+    void copy_out(char *dest, const size_t len) const;
+
+    //! Copy up to `len` bytes from `data` into the stream
+    //! \returns the number of bytes accepted into the stream
+    size_t append(const char *data, const size_t len);
+
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Storage storage = Storage::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -39,6 +62,32 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write a string of bytes into the stream, taking ownership of
+    //! it if the stream is Storage::Chunked.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a view of a string of bytes into the stream
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string_view data) { return append(data.data(), data.size()); }
+
+    //! Write a C string (must be NULL-terminated) into the stream
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const char *data);
+
+    //! Write a discontiguous string of bytes into the stream
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const BufferViewList &data);
+
+    //! \brief Expose up to `len` bytes of free space at the input side of the stream
+    //! \returns up to two `iovec`s for [readv(2)](\ref man2::readv) to fill, or none for Storage::Chunked
+    //! or a full stream
+    //! \note The caller must then call commit_write() with the number of bytes it filled in.
+    std::vector<iovec> writable_iovecs(const size_t len);
+
+    //! Account for `len` bytes written directly into the space from writable_iovecs()
+    void commit_write(const size_t len);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
@@ -56,6 +105,11 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns up to two views into the stream's storage (the ring may wrap around)
+    //! \note The views are invalidated by the next call that modifies the stream.
+    BufferViewList peek_views(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -63,6 +117,20 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read (i.e., pop) the next "len" bytes of the stream as a Buffer
+    //! \returns a Buffer that shares storage with the written string when
+    //! the stream is Storage::Chunked and the bytes lie within one write
+    Buffer read_buffer(const size_t len);
+
+    //! Read (i.e., copy and then pop) up to "len" bytes of the stream into `dest`
+    //! \returns the number of bytes read
+    size_t read_into(char *dest, const size_t len);
+
+    //! Read (i.e., copy and then pop) up to "len" bytes of the stream into `str`
+    //! (caller can allocate storage; `str` is resized to the number of bytes read)
+    //! \returns the number of bytes read
+    size_t read_into(std::string &str, const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -79,6 +147,9 @@ class ByteStream {
     bool eof() const;
     //!@}
 
+    //! \returns how the stream holds its bytes
+    Storage storage() const { return storage_; }
+
     //! \name General accounting
     //!@{
 
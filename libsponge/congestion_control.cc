@@ -0,0 +1,289 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+unique_ptr<CongestionControl> CongestionControl::make(const Algorithm algorithm, const size_t mss) {
+    switch (algorithm) {
+        case Algorithm::None:
+            return nullptr;
+        case Algorithm::NewReno:
+            return make_unique<NewReno>(mss);
+        case Algorithm::Cubic:
+            return make_unique<Cubic>(mss);
+        case Algorithm::Bbr:
+            return make_unique<Bbr>(mss);
+    }
+    throw invalid_argument("unknown congestion-control algorithm");
+}
+
+CongestionControl::Algorithm CongestionControl::algorithm_from_name(const string &name) {
+    if (name == "none") {
+        return Algorithm::None;
+    }
+    if (name == "newreno") {
+        return Algorithm::NewReno;
+    }
+    if (name == "cubic") {
+        return Algorithm::Cubic;
+    }
+    if (name == "bbr") {
+        return Algorithm::Bbr;
+    }
+    throw invalid_argument("unknown congestion-control algorithm: " + name);
+}
+
+NewReno::NewReno(const size_t mss)
+    : mss_(mss), cwnd_(INITIAL_WINDOW_SEGMENTS * mss), ssthresh_(numeric_limits<size_t>::max()) {}
+
+void NewReno::on_ack(const size_t acked, const size_t bytes_in_flight) {
+    // don't grow a window that the sender isn't using
+    if (bytes_in_flight + acked < cwnd_) {
+        return;
+    }
+
+    if (cwnd_ < ssthresh_) {
+        cwnd_ += min(acked, 2 * mss_);
+        return;
+    }
+
+    acked_in_avoidance_ += acked;
+    if (acked_in_avoidance_ >= cwnd_) {
+        acked_in_avoidance_ -= cwnd_;
+        cwnd_ += mss_;
+    }
+}
+
+void NewReno::on_loss(const size_t bytes_in_flight) {
+    ssthresh_ = max(bytes_in_flight / 2, 2 * mss_);
+    cwnd_ = ssthresh_;
+    acked_in_avoidance_ = 0;
+}
+
+void NewReno::on_rto(const size_t bytes_in_flight) {
+    ssthresh_ = max(bytes_in_flight / 2, 2 * mss_);
+    cwnd_ = mss_;
+    acked_in_avoidance_ = 0;
+}
+
+Cubic::Cubic(const size_t mss)
+    : mss_(mss), cwnd_(NewReno::INITIAL_WINDOW_SEGMENTS * mss), ssthresh_(numeric_limits<size_t>::max()) {}
+
+double Cubic::w_cubic(const double t) const { return C * pow(t - k_, 3) * mss_ + w_max_; }
+
+void Cubic::on_ack(const size_t acked, const size_t bytes_in_flight) {
+    acked_total_ += acked;
+    if (acked_total_ >= round_end_) {
+        // a new HyStart round begins: it ends once everything now in flight is acknowledged
+        round_end_ = acked_total_ + bytes_in_flight;
+        if (round_rtt_samples_ >= HYSTART_MIN_SAMPLES) {
+            last_round_min_rtt_ = round_min_rtt_;
+        }
+        round_min_rtt_ = NO_RTT;
+        round_rtt_samples_ = 0;
+    }
+
+    // don't grow a window that the sender isn't using
+    if (bytes_in_flight + acked < cwnd()) {
+        return;
+    }
+
+    if (cwnd() < ssthresh_) {
+        cwnd_ += min(acked, 2 * mss_);
+        return;
+    }
+
+    if (not in_epoch_) {
+        in_epoch_ = true;
+        epoch_start_ms_ = now_ms_;
+        if (w_max_ < cwnd_) {
+            // no loss yet (HyStart ended slow start), or the window has already regained its old size
+            w_max_ = cwnd_;
+        }
+        k_ = cbrt((w_max_ - cwnd_) / (C * mss_));
+        w_est_ = cwnd_;
+    }
+
+    // the window the curve will reach one RTT from now, but no more than 1.5 times the current one
+    const double rtt = min_rtt_ms_ == NO_RTT ? 0 : min_rtt_ms_ / 1000.0;
+    const double t = (now_ms_ - epoch_start_ms_) / 1000.0;
+    const double target = clamp(w_cubic(t + rtt), cwnd_, 1.5 * cwnd_);
+
+    w_est_ += 3 * (1 - BETA) / (1 + BETA) * acked * mss_ / cwnd_;
+    if (w_cubic(t) < w_est_) {
+        cwnd_ = max(cwnd_, w_est_);
+    } else {
+        cwnd_ += (target - cwnd_) * acked / cwnd_;
+    }
+}
+
+void Cubic::reduce() {
+    // fast convergence: a window that didn't get back to its last maximum gives up more
+    w_max_ = cwnd_ < w_max_ ? cwnd_ * (1 + BETA) / 2 : cwnd_;
+    ssthresh_ = max(static_cast<size_t>(cwnd_ * BETA), 2 * mss_);
+    in_epoch_ = false;
+}
+
+void Cubic::on_loss(const size_t bytes_in_flight) {
+    (void)bytes_in_flight;
+    reduce();
+    cwnd_ = ssthresh_;
+}
+
+void Cubic::on_rto(const size_t bytes_in_flight) {
+    (void)bytes_in_flight;
+    reduce();
+    cwnd_ = mss_;
+}
+
+void Cubic::on_rtt_sample(const uint64_t rtt_ms) {
+    min_rtt_ms_ = min(min_rtt_ms_, rtt_ms);
+    if (cwnd() >= ssthresh_) {
+        return;
+    }
+
+    // HyStart: leave slow start once this round's RTT is clearly above the last round's
+    round_min_rtt_ = min(round_min_rtt_, rtt_ms);
+    ++round_rtt_samples_;
+    if (round_rtt_samples_ >= HYSTART_MIN_SAMPLES and last_round_min_rtt_ != NO_RTT) {
+        const uint64_t thresh =
+            clamp(last_round_min_rtt_ / 8, HYSTART_MIN_RTT_THRESH_MS, HYSTART_MAX_RTT_THRESH_MS);
+        if (round_min_rtt_ >= last_round_min_rtt_ + thresh) {
+            ssthresh_ = cwnd();
+        }
+    }
+}
+
+Bbr::Bbr(const size_t mss) : mss_(mss), cwnd_(NewReno::INITIAL_WINDOW_SEGMENTS * mss) {}
+
+double Bbr::bdp() const {
+    return bw_samples_.empty() ? 0 : bw_samples_.front().second * max<uint64_t>(min_rtt_ms_ == NO_RTT ? 0 : min_rtt_ms_, 1);
+}
+
+double Bbr::pacing_gain() const {
+    switch (mode_) {
+        case Mode::Startup:
+            return HIGH_GAIN;
+        case Mode::Drain:
+            return 1 / HIGH_GAIN;
+        case Mode::ProbeBW:
+            return PROBE_BW_GAINS[cycle_index_];
+        case Mode::ProbeRTT:
+            return 1;
+    }
+    return 1;
+}
+
+double Bbr::cwnd_gain() const { return mode_ == Mode::ProbeBW ? PROBE_BW_CWND_GAIN : HIGH_GAIN; }
+
+size_t Bbr::cwnd() const {
+    if (in_rto_recovery_) {
+        return mss_;
+    }
+    if (mode_ == Mode::ProbeRTT) {
+        return MIN_CWND_SEGMENTS * mss_;
+    }
+    // whole segments, so that pacing doesn't end each window with a tiny segment
+    return max(MIN_CWND_SEGMENTS, cwnd_ / mss_) * mss_;
+}
+
+bool Bbr::update_model(const RateSample &sample) {
+    bool round_start = false;
+    if (sample.prior_delivered >= next_round_delivered_) {
+        next_round_delivered_ = delivered_;
+        ++round_count_;
+        round_start = true;
+    }
+
+    // a windowed max filter: keep only samples that could still be the max of the last BW_FILTER_ROUNDS rounds
+    const double bw = double(sample.delivered) / sample.interval_ms;
+    while (not bw_samples_.empty() and bw_samples_.back().second <= bw) {
+        bw_samples_.pop_back();
+    }
+    bw_samples_.emplace_back(round_count_, bw);
+    while (bw_samples_.front().first + BW_FILTER_ROUNDS <= round_count_) {
+        bw_samples_.pop_front();
+    }
+    return round_start;
+}
+
+void Bbr::update_mode(const bool round_start, const bool min_rtt_expired) {
+    if (mode_ == Mode::Startup and round_start and not filled_pipe_) {
+        // the pipe is full once three rounds in a row fail to grow the bandwidth by a quarter
+        const double bw = bottleneck_bandwidth();
+        if (bw >= full_bw_ * 1.25) {
+            full_bw_ = bw;
+            full_bw_rounds_ = 0;
+        } else if (++full_bw_rounds_ >= FULL_BW_ROUNDS) {
+            filled_pipe_ = true;
+            mode_ = Mode::Drain;
+        }
+    }
+
+    if (mode_ == Mode::Drain and bytes_in_flight_ <= bdp()) {
+        mode_ = Mode::ProbeBW;
+        cycle_index_ = 2;
+        cycle_start_ms_ = now_ms_;
+    }
+
+    if (mode_ == Mode::ProbeBW and now_ms_ - cycle_start_ms_ > min_rtt_ms_) {
+        cycle_index_ = (cycle_index_ + 1) % size(PROBE_BW_GAINS);
+        cycle_start_ms_ = now_ms_;
+    }
+
+    if (mode_ != Mode::ProbeRTT and min_rtt_expired) {
+        mode_ = Mode::ProbeRTT;
+        probe_rtt_done_ms_ = now_ms_ + PROBE_RTT_DURATION_MS;
+    } else if (mode_ == Mode::ProbeRTT and now_ms_ >= probe_rtt_done_ms_) {
+        // whatever the RTT was during ProbeRTT is the new estimate
+        min_rtt_stamp_ms_ = now_ms_;
+        mode_ = filled_pipe_ ? Mode::ProbeBW : Mode::Startup;
+        cycle_start_ms_ = now_ms_;
+    }
+}
+
+void Bbr::on_ack(const size_t acked, const size_t bytes_in_flight) {
+    delivered_ += acked;
+    bytes_in_flight_ = bytes_in_flight;
+    in_rto_recovery_ = false;
+
+    // an RTT sample replaces the estimate if it's smaller, or if the estimate is too old
+    const bool min_rtt_expired = now_ms_ > min_rtt_stamp_ms_ + MIN_RTT_WINDOW_MS;
+    if (pending_rtt_ms_.has_value() and (pending_rtt_ms_.value() <= min_rtt_ms_ or min_rtt_expired)) {
+        min_rtt_ms_ = pending_rtt_ms_.value();
+        min_rtt_stamp_ms_ = now_ms_;
+    }
+    pending_rtt_ms_.reset();
+
+    bool round_start = false;
+    if (pending_sample_.has_value()) {
+        round_start = update_model(pending_sample_.value());
+        pending_sample_.reset();
+    }
+    update_mode(round_start, min_rtt_expired);
+
+    // grow toward the target window; until the first window is delivered the model is too young to trust
+    const size_t target = max<size_t>(cwnd_gain() * bdp(), MIN_CWND_SEGMENTS * mss_);
+    if (filled_pipe_) {
+        cwnd_ = min(cwnd_ + acked, target);
+    } else if (cwnd_ < target or delivered_ < NewReno::INITIAL_WINDOW_SEGMENTS * mss_) {
+        cwnd_ += acked;
+    }
+}
+
+void Bbr::on_rtt_sample(const uint64_t rtt_ms) {
+    // below the clock's resolution: a zero would make the bandwidth-delay product meaningless
+    if (rtt_ms > 0) {
+        pending_rtt_ms_ = rtt_ms;
+    }
+}
+
+void Bbr::on_rto(const size_t bytes_in_flight) {
+    bytes_in_flight_ = bytes_in_flight;
+    in_rto_recovery_ = true;
+}
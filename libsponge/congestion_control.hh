@@ -0,0 +1,294 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+//! \brief The interface between a TCPSender and a congestion-control algorithm.
+
+//! The TCPSender reports acknowledgments and losses; the algorithm answers with a
+//! congestion window, which the sender combines with the receiver's window to decide
+//! how many bytes (in sequence space) may be outstanding.
+class CongestionControl {
+  public:
+    //! The congestion-control algorithms available to a TCPSender
+    enum class Algorithm {
+        None,     //!< no congestion window: only the receiver's window limits the sender (the default)
+        NewReno,  //!< slow start and congestion avoidance after RFC 5681 and RFC 6582
+        Cubic,    //!< CUBIC window growth (RFC 9438) with HyStart slow-start exit
+        Bbr       //!< BBR-style model of the path's bandwidth and RTT, with pacing
+    };
+
+    //! \brief What one acknowledgment says about the rate at which the path delivers bytes
+    struct RateSample {
+        uint64_t prior_delivered;  //!< bytes acknowledged in total when the newly acked segment was sent
+        uint64_t delivered;        //!< bytes acknowledged since then, including by this acknowledgment
+        uint64_t interval_ms;      //!< time since then (non-zero)
+    };
+
+    //! \returns a new instance of `algorithm` for segments of up to `mss` bytes, or nullptr for Algorithm::None
+    static std::unique_ptr<CongestionControl> make(const Algorithm algorithm, const size_t mss);
+
+    //! \returns the algorithm called `name` ("none", "newreno", ...)
+    //! \throws std::invalid_argument if there is no such algorithm
+    static Algorithm algorithm_from_name(const std::string &name);
+
+    virtual ~CongestionControl() = default;
+
+    //! \name Events reported by the TCPSender
+    //!@{
+
+    //! \brief `acked` more sequence numbers were cumulatively acknowledged
+    //! \param bytes_in_flight the sequence numbers still outstanding after the acknowledgment
+    virtual void on_ack(const size_t acked, const size_t bytes_in_flight) = 0;
+
+    //! \brief A loss was detected without waiting for the retransmission timer (e.g., by duplicate acks)
+    //! \param bytes_in_flight the sequence numbers outstanding when the loss was detected
+    virtual void on_loss(const size_t bytes_in_flight) = 0;
+
+    //! \brief The retransmission timer expired
+    //! \param bytes_in_flight the sequence numbers outstanding when the timer expired
+    virtual void on_rto(const size_t bytes_in_flight) = 0;
+
+    //! \brief A segment that was never retransmitted was acknowledged `rtt_ms` after it was sent
+    //! \note Reported before the on_ack() for the same acknowledgment
+    virtual void on_rtt_sample(const uint64_t rtt_ms) { (void)rtt_ms; }
+
+    //! \brief A delivery-rate sample, from the same segment as the on_rtt_sample() before it
+    virtual void on_rate_sample(const RateSample &sample) { (void)sample; }
+
+    //! \brief Time passed (the TCPSender's clock)
+    virtual void tick(const size_t ms_since_last_tick) { (void)ms_since_last_tick; }
+    //!@}
+
+    //! \name The algorithm's state
+    //!@{
+
+    //! \returns the congestion window, in bytes
+    virtual size_t cwnd() const = 0;
+
+    //! \returns the slow-start threshold, in bytes
+    virtual size_t ssthresh() const = 0;
+
+    //! \returns the rate at which the sender should pace new segments, in bytes per second (0 for no pacing)
+    virtual double pacing_rate() const { return 0; }
+
+    //! \returns the algorithm's name, as accepted by algorithm_from_name()
+    virtual std::string name() const = 0;
+    //!@}
+};
+
+//! \brief NewReno congestion control.
+
+//! Slow start grows the window by up to two segments per acknowledgment (RFC 3465's
+//! appropriate byte counting with L = 2); congestion avoidance grows it by one segment
+//! per window of acknowledged bytes. A loss halves the window, and a retransmission
+//! timeout collapses it to one segment.
+class NewReno : public CongestionControl {
+  private:
+    size_t mss_;
+    size_t cwnd_;
+    size_t ssthresh_;
+    size_t acked_in_avoidance_{0};  //!< bytes acknowledged since the window last grew in congestion avoidance
+
+  public:
+    //! The initial window, in segments (RFC 6928)
+    static constexpr size_t INITIAL_WINDOW_SEGMENTS = 10;
+
+    explicit NewReno(const size_t mss);
+
+    void on_ack(const size_t acked, const size_t bytes_in_flight) override;
+    void on_loss(const size_t bytes_in_flight) override;
+    void on_rto(const size_t bytes_in_flight) override;
+
+    size_t cwnd() const override { return cwnd_; }
+    size_t ssthresh() const override { return ssthresh_; }
+    std::string name() const override { return "newreno"; }
+};
+
+//! \brief CUBIC congestion control.
+
+//! Slow start is as in NewReno, but ends early if HyStart sees the round-trip time
+//! rise (RFC 9406's delay-increase test). In congestion avoidance the window follows
+//! W(t) = C (t - K)^3 + W_max, where t is the time since the last loss and K is when
+//! the curve returns to the window at that loss (RFC 9438), or the Reno-friendly
+//! estimate if that is larger. Time comes from tick().
+class Cubic : public CongestionControl {
+  private:
+    static constexpr uint64_t NO_RTT = std::numeric_limits<uint64_t>::max();
+
+    size_t mss_;
+    double cwnd_;                  //!< in bytes, fractional so that small increments accumulate
+    size_t ssthresh_;
+    uint64_t now_ms_{0};           //!< milliseconds of tick() so far
+    uint64_t min_rtt_ms_{NO_RTT};  //!< smallest RTT sample ever seen
+
+    //! \name Congestion avoidance epoch (starts at the first ack after a loss)
+    //!@{
+    bool in_epoch_{false};
+    uint64_t epoch_start_ms_{0};
+    double w_max_{0};  //!< window (bytes) just before the last loss
+    double k_{0};      //!< seconds from epoch start until W(t) reaches w_max_
+    double w_est_{0};  //!< Reno-friendly window estimate (bytes)
+    //!@}
+
+    //! \name HyStart state (in slow start only)
+    //! A round ends when the bytes that were in flight when it began have been acknowledged.
+    //!@{
+    uint64_t acked_total_{0};
+    uint64_t round_end_{0};
+    uint64_t last_round_min_rtt_{NO_RTT};
+    uint64_t round_min_rtt_{NO_RTT};
+    size_t round_rtt_samples_{0};
+    //!@}
+
+    //! Shrink the window after a loss, remembering where it was
+    void reduce();
+
+    //! \returns the cubic curve W(t) for `t` seconds since the epoch started, in bytes
+    double w_cubic(const double t) const;
+
+  public:
+    //! \name CUBIC parameters (RFC 9438)
+    //!@{
+    static constexpr double C = 0.4;     //!< in segments per second cubed
+    static constexpr double BETA = 0.7;  //!< multiplicative decrease
+    //!@}
+
+    //! \name HyStart parameters (RFC 9406)
+    //!@{
+    static constexpr size_t HYSTART_MIN_SAMPLES = 8;
+    static constexpr uint64_t HYSTART_MIN_RTT_THRESH_MS = 4;
+    static constexpr uint64_t HYSTART_MAX_RTT_THRESH_MS = 16;
+    //!@}
+
+    explicit Cubic(const size_t mss);
+
+    void on_ack(const size_t acked, const size_t bytes_in_flight) override;
+    void on_loss(const size_t bytes_in_flight) override;
+    void on_rto(const size_t bytes_in_flight) override;
+    void on_rtt_sample(const uint64_t rtt_ms) override;
+    void tick(const size_t ms_since_last_tick) override { now_ms_ += ms_since_last_tick; }
+
+    //! \returns the window in whole segments, so that its fractional growth doesn't produce tiny segments
+    size_t cwnd() const override { return std::max(mss_, static_cast<size_t>(cwnd_ / mss_) * mss_); }
+    size_t ssthresh() const override { return ssthresh_; }
+    std::string name() const override { return "cubic"; }
+};
+
+//! \brief BBR-style congestion control.
+
+//! Instead of reacting to loss, BBR models the path: the bottleneck bandwidth is the
+//! largest delivery rate seen over the last ten rounds, and the propagation delay is the
+//! smallest RTT seen over the last ten seconds. The sender paces at a multiple of the
+//! bandwidth, and the window is a multiple of the bandwidth-delay product (BDP).
+//!
+//! Startup doubles the sending rate each round until the bandwidth stops growing; Drain
+//! empties the queue that built up; ProbeBW then cycles the pacing gain to look for
+//! more bandwidth and drain what that added; and ProbeRTT briefly shrinks the window to
+//! measure the RTT again if it hasn't been refreshed for ten seconds. Random losses do
+//! not shrink the window.
+class Bbr : public CongestionControl {
+  public:
+    //! The phases of BBR's state machine
+    enum class Mode { Startup, Drain, ProbeBW, ProbeRTT };
+
+    //! \name BBR parameters
+    //!@{
+    static constexpr double HIGH_GAIN = 2.885;  //!< 2/ln(2): doubles the delivery rate each round
+    static constexpr double PROBE_BW_CWND_GAIN = 2;
+    static constexpr double PROBE_BW_GAINS[] = {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+    static constexpr size_t BW_FILTER_ROUNDS = 10;
+    static constexpr size_t FULL_BW_ROUNDS = 3;  //!< rounds without 25% growth that end Startup
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;
+    static constexpr uint64_t PROBE_RTT_DURATION_MS = 200;
+    static constexpr size_t MIN_CWND_SEGMENTS = 4;
+    //!@}
+
+  private:
+    static constexpr uint64_t NO_RTT = std::numeric_limits<uint64_t>::max();
+
+    size_t mss_;
+    Mode mode_{Mode::Startup};
+    uint64_t now_ms_{0};
+    size_t cwnd_;
+    size_t bytes_in_flight_{0};
+    bool in_rto_recovery_{false};  //!< one segment at a time until the next ack after a timeout
+
+    //! \name Rounds: a round ends when a segment sent after it began is acknowledged
+    //!@{
+    uint64_t delivered_{0};
+    uint64_t next_round_delivered_{0};
+    uint64_t round_count_{0};
+    //!@}
+
+    //! \name The path model
+    //!@{
+    std::deque<std::pair<uint64_t, double>> bw_samples_{};  //!< (round, bytes/ms), decreasing in bytes/ms
+    uint64_t min_rtt_ms_{NO_RTT};
+    uint64_t min_rtt_stamp_ms_{0};  //!< when min_rtt_ms_ was last measured
+    //!@}
+
+    //! \name Leaving Startup
+    //!@{
+    double full_bw_{0};
+    size_t full_bw_rounds_{0};
+    bool filled_pipe_{false};
+    //!@}
+
+    size_t cycle_index_{0};        //!< ProbeBW's place in PROBE_BW_GAINS
+    uint64_t cycle_start_ms_{0};
+    uint64_t probe_rtt_done_ms_{0};
+
+    //! The samples to fold into the model at the next on_ack()
+    std::optional<uint64_t> pending_rtt_ms_{};
+    std::optional<RateSample> pending_sample_{};
+
+    //! \returns the estimated bandwidth-delay product, in bytes
+    double bdp() const;
+
+    double pacing_gain() const;
+    double cwnd_gain() const;
+
+    //! Fold a delivery-rate sample into the bandwidth filter, counting rounds
+    //! \returns whether the sample started a new round
+    bool update_model(const RateSample &sample);
+
+    //! Advance the state machine after an acknowledgment
+    void update_mode(const bool round_start, const bool min_rtt_expired);
+
+  public:
+    explicit Bbr(const size_t mss);
+
+    void on_ack(const size_t acked, const size_t bytes_in_flight) override;
+    void on_loss(const size_t bytes_in_flight) override { (void)bytes_in_flight; }
+    void on_rto(const size_t bytes_in_flight) override;
+    void on_rtt_sample(const uint64_t rtt_ms) override;
+    void on_rate_sample(const RateSample &sample) override { pending_sample_ = sample; }
+    void tick(const size_t ms_since_last_tick) override { now_ms_ += ms_since_last_tick; }
+
+    size_t cwnd() const override;
+    size_t ssthresh() const override { return std::numeric_limits<size_t>::max(); }
+    double pacing_rate() const override { return pacing_gain() * bottleneck_bandwidth(); }
+    std::string name() const override { return "bbr"; }
+
+    //! \name The model, for tests and statistics
+    //!@{
+    Mode mode() const { return mode_; }
+
+    //! \returns the estimated bottleneck bandwidth, in bytes per second
+    double bottleneck_bandwidth() const { return bw_samples_.empty() ? 0 : bw_samples_.front().second * 1000; }
+
+    //! \returns the estimated propagation delay, in milliseconds (or the maximum value if there's no estimate yet)
+    uint64_t min_rtt_ms() const { return min_rtt_ms_; }
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
@@ -0,0 +1,62 @@
+#include "reassembly_budget.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+ReassemblyBudget &ReassemblyBudget::global() {
+    static ReassemblyBudget budget;
+    return budget;
+}
+
+size_t ReassemblyBudget::available() const {
+    const size_t limit = limit_, held = held_;
+    return held >= limit ? 0 : limit - held;
+}
+
+void ReassemblyBudget::raise_peak(const size_t held) {
+    size_t peak = peak_;
+    while (held > peak and not peak_.compare_exchange_weak(peak, held)) {
+    }
+}
+
+ReassemblyBudget::Charge &ReassemblyBudget::Charge::operator=(Charge &&other) noexcept {
+    if (this != &other) {
+        set(0);
+        budget_ = other.budget_;
+        charged_ = other.charged_;
+        other.charged_ = 0;
+    }
+    return *this;
+}
+
+size_t ReassemblyBudget::Charge::reserve(const size_t wanted) {
+    if (not budget_) {
+        return wanted;
+    }
+
+    // claim the bytes with a compare-and-swap so that concurrent reservations can't overshoot the limit
+    size_t held = budget_->held_;
+    size_t granted;
+    do {
+        const size_t limit = budget_->limit_;
+        granted = min(wanted, held >= limit ? 0 : limit - held);
+    } while (granted > 0 and not budget_->held_.compare_exchange_weak(held, held + granted));
+
+    budget_->raise_peak(held + granted);
+    charged_ += granted;
+    return granted;
+}
+
+void ReassemblyBudget::Charge::set(const size_t bytes) {
+    if (not budget_ or bytes == charged_) {
+        charged_ = bytes;
+        return;
+    }
+    if (bytes < charged_) {
+        budget_->held_ -= charged_ - bytes;
+    } else {
+        budget_->raise_peak(budget_->held_.fetch_add(bytes - charged_) + (bytes - charged_));
+    }
+    charged_ = bytes;
+}
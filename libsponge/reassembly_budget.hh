@@ -0,0 +1,83 @@
+#ifndef SPONGE_LIBSPONGE_REASSEMBLY_BUDGET_HH
+#define SPONGE_LIBSPONGE_REASSEMBLY_BUDGET_HH
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+
+//! \brief A limit on the out-of-order bytes held by a group of StreamReassemblers.
+
+//! Each connection's receive window bounds what its own reassembler may hold, but
+//! with many connections the sum of those windows can be far more memory than the
+//! process should spend on bytes that can't be delivered yet. Reassemblers that
+//! share a budget draw from it before storing out-of-order bytes and give the
+//! bytes back once they are assembled (or the reassembler goes away).
+//!
+//! The counters are atomic, so one budget can be shared by connections that run
+//! in different threads (e.g., several TCPSpongeSockets).
+class ReassemblyBudget {
+  public:
+    //! What a TCPReceiver does besides dropping out-of-order bytes when its budget is exhausted
+    enum class Policy {
+        DropNewest,   //!< only drop the bytes that don't fit (the default)
+        ShrinkWindow  //!< also shrink the advertised window to what can still be held
+    };
+
+    //! \brief Bytes charged to a budget on behalf of one owner.
+    //! Releases whatever is still charged when destroyed; moving transfers the charge.
+    class Charge {
+        ReassemblyBudget *budget_;
+        size_t charged_{0};
+
+      public:
+        explicit Charge(ReassemblyBudget *budget = nullptr) : budget_(budget) {}
+        ~Charge() { set(0); }
+        Charge(Charge &&other) noexcept : budget_(other.budget_), charged_(other.charged_) { other.charged_ = 0; }
+        Charge &operator=(Charge &&other) noexcept;
+        Charge(const Charge &other) = delete;
+        Charge &operator=(const Charge &other) = delete;
+
+        //! Take up to `wanted` more bytes from the budget
+        //! \returns the number of bytes granted (all of them if there is no budget)
+        size_t reserve(const size_t wanted);
+
+        //! Adjust the charge to exactly `bytes`, giving back (or taking) the difference
+        void set(const size_t bytes);
+
+        //! \returns the budget this charge draws from, or nullptr if it is unlimited
+        const ReassemblyBudget *budget() const { return budget_; }
+    };
+
+  private:
+    std::atomic<size_t> limit_;
+    std::atomic<size_t> held_{0};
+    std::atomic<size_t> peak_{0};
+
+    //! Record that `held` bytes are held, if that's a new peak
+    void raise_peak(const size_t held);
+
+  public:
+    //! Construct a budget of `limit` bytes
+    explicit ReassemblyBudget(const size_t limit = std::numeric_limits<size_t>::max()) : limit_(limit) {}
+
+    //! The budget shared by every TCPReceiver in the process (unlimited unless set_limit() is called)
+    static ReassemblyBudget &global();
+
+    //! \name Limit and statistics
+    //!@{
+    size_t limit() const { return limit_; }
+    void set_limit(const size_t limit) { limit_ = limit; }
+
+    //! Bytes currently held out of order by all reassemblers sharing this budget
+    size_t held() const { return held_; }
+
+    //! The most bytes ever held at once (since construction or the last reset_peak())
+    size_t peak() const { return peak_; }
+    void reset_peak() { peak_ = held_.load(); }
+
+    //! Bytes that may still be charged before the limit is reached
+    size_t available() const;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_REASSEMBLY_BUDGET_HH
@@ -1,5 +1,8 @@
 #include "stream_reassembler.hh"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <utility>
 
 // Dummy implementation of a stream reassembler.
@@ -14,58 +17,289 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : output_(capacity), capacity_(capacity), unassembled_bytes_(0), begin_(0), first_unass_index_(0), eof_(false), buffer_(capacity, make_pair<bool, char>(false, ' ')) { }
+//! Number of bits in one word of the Backend::Bitmap occupancy bitmap
+static constexpr size_t WORD_BITS = 64;
+
+//! \returns the smallest power of two that is at least `n` (and at least one bitmap word)
+static size_t ring_size_for(const size_t n) {
+    size_t ret = WORD_BITS;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
+
+StreamReassembler::StreamReassembler(const size_t capacity,
+                                     const Backend backend,
+                                     ReassemblyBudget *budget,
+                                     const size_t unassembled_limit)
+    : backend_(backend)
+    , output_(capacity)
+    , capacity_(capacity)
+    , unassembled_bytes_(0)
+    , first_unass_index_(0)
+    , unassembled_limit_(unassembled_limit)
+    , charge_(budget) {}
 
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 //! Since the output stream has the same capacity, the write is always successful.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    if (eof && index + data.length() <= output_.bytes_read() + capacity_) eof_ = eof;
-    if (index <= first_unass_index_) {
-        // may push substring to ByteStream
-	string pushed;
-	for (auto i = first_unass_index_; i < min(index + data.length(), output_.bytes_read() + capacity_); ++i) {
-	    check(begin_);
-            if (buffer_[begin_].first) {
-                buffer_[begin_].first = false;
-		--unassembled_bytes_;
-	    }
-	    pushed.push_back(data[i - index]);
-	    begin_ = (begin_ + 1) % capacity_;
-	}
-	for (auto j = pushed.length(); j < output_.bytes_read() + capacity_ - first_unass_index_; ++j) {
-	    check(begin_);
-	    if (buffer_[begin_].first) {
-                buffer_[begin_].first = false;
-		pushed.push_back(buffer_[begin_].second);
-		begin_ = (begin_ + 1) % capacity_;
-		--unassembled_bytes_;
-	    } else break;
-	}
-	first_unass_index_ += pushed.length();
-	// the following write should always be successful
-	output_.write(pushed);
-	if (eof_ && empty()) output_.end_input();
+    push({data, nullptr}, index, eof);
+}
+
+void StreamReassembler::push_substring(const string_view data, const size_t index, const bool eof) {
+    push({data, nullptr}, index, eof);
+}
+
+void StreamReassembler::push_substring(const char *data, const size_t index, const bool eof) {
+    push({data, nullptr}, index, eof);
+}
+
+void StreamReassembler::push_substring(const Buffer &data, const size_t index, const bool eof) {
+    push({data.str(), &data}, index, eof);
+}
+
+void StreamReassembler::push(const Substring &data, const size_t index, const bool eof) {
+    const uint64_t first_unacceptable = output_.bytes_read() + capacity_;
+    if (eof && index + data.data.size() <= first_unacceptable) eof_index_ = index + data.data.size();
+
+    // only the part of the substring inside the window [first_unass_index_, first_unacceptable) is kept
+    const uint64_t begin = max(index, first_unass_index_);
+    const uint64_t end = min(index + data.data.size(), first_unacceptable);
+    if (begin < end && begin == first_unass_index_ && unassembled_bytes_ == 0) {
+        // fast path: in order with nothing pending, so the bytes go straight to the output
+        // (which has room for the whole window, so the write always succeeds)
+        ++fast_path_pushes_;
+        first_unass_index_ += output_.write(data.data.substr(begin - index, end - begin));
     } else {
-	size_t j = (begin_ + index - first_unass_index_) % capacity_;
-	for (auto i = index; i < min(index + data.length(), output_.bytes_read() + capacity_); ++i, j = (j + 1) % capacity_) {
-	    check(j);
-            if (!buffer_[j].first) {
-		buffer_[j].first = true;
-		buffer_[j].second = data[i - index];
-		++unassembled_bytes_;
-	    }
-	}	
-    }	    
-    
+        ++slow_path_pushes_;
+        if (begin < end) {
+            if (begin == first_unass_index_) {
+                first_unass_index_ += output_.write(data.data.substr(begin - index, end - begin));
+                flush(begin);
+            } else {
+                store_within_budget(data, index, begin, end);
+            }
+        }
+        charge_.set(unassembled_bytes_);
+        peak_unassembled_bytes_ = max(peak_unassembled_bytes_, unassembled_bytes_);
+    }
+
+    if (eof_index_ && first_unass_index_ == *eof_index_) output_.end_input();
+}
+
+void StreamReassembler::store_within_budget(const Substring &data,
+                                            const uint64_t index,
+                                            const uint64_t begin,
+                                            uint64_t end) {
+    // Drop the newest bytes (the tail of this substring) that don't fit. Bytes that are
+    // already pending count against the room too, so this can drop a little early.
+    const size_t room = unassembled_limit_ > unassembled_bytes_ ? unassembled_limit_ - unassembled_bytes_ : 0;
+    const size_t granted = charge_.reserve(min<uint64_t>(room, end - begin));
+    if (granted < end - begin) {
+        dropped_bytes_ += end - begin - granted;
+        end = begin + granted;
+    }
+    if (begin < end) {
+        store(data, index, begin, end);
+    }
+}
+
+void StreamReassembler::store(const Substring &data, const uint64_t index, uint64_t begin, uint64_t end) {
+    if (backend_ == Backend::Bitmap) {
+        store_bitmap(data.data, index, begin, end);
+        return;
+    }
+
+    // trim the front against a pending substring that starts before `begin`
+    auto it = pending_.upper_bound(begin);
+    if (it != pending_.begin()) {
+        const auto &[prev_index, prev_data] = *prev(it);
+        const uint64_t prev_end = prev_index + prev_data.size();
+        if (prev_end >= end) return;
+        begin = max(begin, prev_end);
+    }
+
+    // replace pending substrings that the new one covers, and trim the back against the first one it doesn't
+    while (it != pending_.end() && it->first < end) {
+        const uint64_t it_end = it->first + it->second.size();
+        if (it_end > end) {
+            end = it->first;
+            break;
+        }
+        unassembled_bytes_ -= it->second.size();
+        it = pending_.erase(it);
+    }
+
+    if (begin < end) {
+        if (data.storage) {
+            // a slice of the caller's Buffer, sharing its storage
+            Buffer slice = *data.storage;
+            slice.remove_prefix(begin - index);
+            slice.remove_suffix(slice.size() - (end - begin));
+            pending_.emplace_hint(it, begin, move(slice));
+        } else {
+            pending_.emplace_hint(it, begin, string(data.data.substr(begin - index, end - begin)));
+        }
+        unassembled_bytes_ += end - begin;
+    }
+}
+
+void StreamReassembler::flush(const uint64_t written_from) {
+    if (backend_ == Backend::Bitmap) {
+        flush_bitmap(written_from);
+        return;
+    }
+
+    while (!pending_.empty() && pending_.begin()->first <= first_unass_index_) {
+        auto &[seg_index, seg_data] = *pending_.begin();
+        if (seg_index + seg_data.size() > first_unass_index_) {
+            first_unass_index_ += output_.write(seg_data.str().substr(first_unass_index_ - seg_index));
+        }
+        unassembled_bytes_ -= seg_data.size();
+        pending_.erase(pending_.begin());
+    }
+}
+
+void StreamReassembler::store_bitmap(const string_view data,
+                                     const uint64_t index,
+                                     const uint64_t begin,
+                                     const uint64_t end) {
+    reserve_ring(end);
+
+    // copy the bytes in (at most two spans of the ring); bytes already held are identical, so overwriting is harmless
+    const size_t len = end - begin;
+    const size_t slot = begin & ring_mask_;
+    const size_t first = min(len, ring_.size() - slot);
+    memcpy(ring_.data() + slot, data.data() + (begin - index), first);
+    memcpy(ring_.data(), data.data() + (begin - index) + first, len - first);
+
+    unassembled_bytes_ += mark(begin, end, true);
+}
+
+void StreamReassembler::flush_bitmap(const uint64_t written_from) {
+    if (ring_.empty()) {
+        return;
+    }
+
+    // bytes that were just written directly no longer need to be held (and any held ones lie within one ring)
+    unassembled_bytes_ -= mark(written_from, min<uint64_t>(first_unass_index_, written_from + ring_.size()), false);
+
+    const size_t window = output_.bytes_read() + capacity_ - first_unass_index_;
+    const size_t run = slot_run(first_unass_index_, window, true);
+    if (run == 0) {
+        return;
+    }
+
+    const size_t slot = first_unass_index_ & ring_mask_;
+    const size_t first = min(run, ring_.size() - slot);
+    output_.write(string_view(ring_.data() + slot, first));
+    output_.write(string_view(ring_.data(), run - first));
+    unassembled_bytes_ -= mark(first_unass_index_, first_unass_index_ + run, false);
+    first_unass_index_ += run;
+}
+
+size_t StreamReassembler::mark(const uint64_t begin, const uint64_t end, const bool occupied) {
+    size_t changed = 0;
+    for (uint64_t i = begin; i < end;) {
+        // one word at a time: the bits [lo, hi) of word (i & ring_mask_) / WORD_BITS
+        const size_t slot = i & ring_mask_;
+        const size_t lo = slot % WORD_BITS;
+        const size_t hi = min<uint64_t>(WORD_BITS, lo + (end - i));
+        const uint64_t bits = (hi == WORD_BITS ? ~uint64_t{0} : (uint64_t{1} << hi) - 1) & (~uint64_t{0} << lo);
+        uint64_t &word = bitmap_[slot / WORD_BITS];
+        if (occupied) {
+            changed += __builtin_popcountll(bits & ~word);
+            word |= bits;
+        } else {
+            changed += __builtin_popcountll(bits & word);
+            word &= ~bits;
+        }
+        i += hi - lo;
+    }
+    return changed;
+}
+
+size_t StreamReassembler::slot_run(const uint64_t from, const size_t limit, const bool occupied) const {
+    size_t run = 0;
+    while (run < limit) {
+        const size_t slot = (from + run) & ring_mask_;
+        const size_t lo = slot % WORD_BITS;
+        // a set bit in `ends` is a slot at or after `slot` within this word that ends the run
+        const uint64_t word = bitmap_[slot / WORD_BITS];
+        const uint64_t ends = (occupied ? ~word : word) >> lo;
+        if (ends != 0) {
+            run += __builtin_ctzll(ends);
+            break;
+        }
+        run += WORD_BITS - lo;
+    }
+    return min(run, limit);
+}
+
+void StreamReassembler::reserve_ring(const uint64_t end) {
+    const size_t needed = end - first_unass_index_;
+    if (needed <= ring_.size()) {
+        return;
+    }
+
+    vector<char> ring(ring_size_for(max(needed, 2 * ring_.size())));
+    vector<uint64_t> bitmap(ring.size() / WORD_BITS);
+    const size_t mask = ring.size() - 1;
+
+    // every held byte lies in [first_unass_index_, first_unass_index_ + ring_.size())
+    for (uint64_t i = first_unass_index_; i < first_unass_index_ + ring_.size(); ++i) {
+        const size_t slot = i & ring_mask_;
+        if ((bitmap_[slot / WORD_BITS] >> (slot % WORD_BITS)) & 1) {
+            const size_t new_slot = i & mask;
+            ring[new_slot] = ring_[slot];
+            bitmap[new_slot / WORD_BITS] |= uint64_t{1} << (new_slot % WORD_BITS);
+        }
+    }
+
+    ring_ = move(ring);
+    bitmap_ = move(bitmap);
+    ring_mask_ = mask;
+}
+
+size_t StreamReassembler::unassembled_room() const {
+    size_t room = unassembled_limit_ > unassembled_bytes_ ? unassembled_limit_ - unassembled_bytes_ : 0;
+    if (charge_.budget()) {
+        room = min(room, charge_.budget()->available());
+    }
+    return room;
 }
 
 size_t StreamReassembler::unassembled_bytes() const { return unassembled_bytes_; }
 
-bool StreamReassembler::empty() const { return unassembled_bytes_ == 0; }
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    if (backend_ == Backend::IntervalMap) {
+        for (const auto &[index, data] : pending_) {
+            if (not ranges.empty() and ranges.back().second == index) {
+                ranges.back().second += data.size();
+            } else {
+                ranges.emplace_back(index, index + data.size());
+            }
+        }
+        return ranges;
+    }
 
-void StreamReassembler::check(size_t index) const {
-    if (index >= capacity_)
-	throw std::out_of_range("Out of range in StreamReassembler!");
+    // every held byte lies in [first_unass_index_, first_unass_index_ + ring_.size())
+    const uint64_t end = first_unass_index_ + ring_.size();
+    size_t found = 0;
+    for (uint64_t i = first_unass_index_; found < unassembled_bytes_ and i < end;) {
+        i += slot_run(i, end - i, false);
+        const size_t run = slot_run(i, end - i, true);
+        if (run > 0) {
+            ranges.emplace_back(i, i + run);
+            found += run;
+            i += run;
+        }
+    }
+    return ranges;
 }
+
+bool StreamReassembler::empty() const { return unassembled_bytes_ == 0; }
@@ -2,30 +2,70 @@
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
 #include "byte_stream.hh"
+#include "reassembly_budget.hh"
 
 #include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! How out-of-order bytes are held until they can be assembled
+    enum class Backend {
+        IntervalMap,  //!< an ordered map of non-overlapping Buffers (the default)
+        Bitmap        //!< a flat ring of bytes plus a bitmap of which ring slots are occupied
+    };
+
   private:
     // Your code here -- add private members as necessary.
 
+    Backend backend_;
     ByteStream output_;        //!< The reassembled in-order byte stream
     size_t capacity_;          //!< The maximum number of bytes
     size_t unassembled_bytes_;   // as the name suggests
-    size_t begin_;             // index in the buffer wrt the first uassembled index 
-    size_t first_unass_index_;
-    bool eof_;                 // whether has reached eof
-    std::vector<std::pair<bool, char>> buffer_;
+    uint64_t first_unass_index_;
+    std::optional<uint64_t> eof_index_{};  // index just past the last byte of the stream, once known
+    uint64_t fast_path_pushes_{0};         // substrings written straight to the output
+    uint64_t slow_path_pushes_{0};         // substrings that consulted the out-of-order state
+    size_t unassembled_limit_;             // most out-of-order bytes this reassembler may hold
+    size_t peak_unassembled_bytes_{0};     // most out-of-order bytes ever held at once
+    uint64_t dropped_bytes_{0};            // in-window out-of-order bytes discarded for lack of budget
+    ReassemblyBudget::Charge charge_;      // the out-of-order bytes, as charged to the shared budget (if any)
 
+    //! Out-of-order substrings keyed by stream index. The substrings never
+    //! overlap, and all of them lie beyond first_unass_index_.
+    std::map<uint64_t, Buffer> pending_{};
+
+    //! \name Backend::Bitmap state
+    //! Stream index `i` lives in ring_[i & ring_mask_], and bit (i & ring_mask_) of
+    //! bitmap_ is set iff that byte is held. Bits outside the window are always clear.
+    //! The ring starts out empty and doubles whenever a held byte wouldn't fit, up to
+    //! the capacity rounded up to a power of two.
+    //!@{
+    std::vector<char> ring_{};
+    std::vector<uint64_t> bitmap_{};
+    size_t ring_mask_{0};
+    //!@}
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    //!
+    //! Out-of-order bytes are further limited to `unassembled_limit` bytes, and to what
+    //! `budget` (shared with other reassemblers) has left, if a budget is given.
+    //! Storage is allocated as bytes arrive, not up front.
+    StreamReassembler(const size_t capacity,
+                      const Backend backend = Backend::IntervalMap,
+                      ReassemblyBudget *budget = nullptr,
+                      const size_t unassembled_limit = std::numeric_limits<size_t>::max());
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -37,6 +77,17 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring without copying it first
+    //! \note Out-of-order bytes are copied into the reassembler's own storage.
+    void push_substring(const std::string_view data, const uint64_t index, const bool eof);
+
+    //! \brief Receive a C string (must be NULL-terminated)
+    void push_substring(const char *data, const uint64_t index, const bool eof);
+
+    //! \brief Receive a substring held in a Buffer (e.g., a segment's payload)
+    //! \note Out-of-order bytes are kept as a slice of `data`, sharing its storage (with Backend::IntervalMap).
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return output_; }
@@ -49,13 +100,68 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! The stored but not yet reassembled bytes, as ranges [begin, end) of stream indices in increasing order
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_ranges() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
-  
+
+    //! \name Counters of how push_substring handled each substring
+    //!@{
+
+    //! Substrings that arrived in order while nothing was pending, and were appended to the output directly
+    uint64_t fast_path_pushes() const { return fast_path_pushes_; }
+
+    //! Substrings that arrived out of order, duplicated, or while out-of-order bytes were pending
+    uint64_t slow_path_pushes() const { return slow_path_pushes_; }
+
+    //! The most bytes that have been stored but not yet reassembled at any one time
+    size_t peak_unassembled_bytes() const { return peak_unassembled_bytes_; }
+
+    //! Bytes inside the window that were discarded because `unassembled_limit` or the budget was exhausted
+    uint64_t dropped_bytes() const { return dropped_bytes_; }
+    //!@}
+
+    //! \returns how many more out-of-order bytes could be stored right now,
+    //! counting both `unassembled_limit` and the shared budget
+    size_t unassembled_room() const;
+
   private:
-    // buffer_ boudary check
-    void check(size_t) const;
+    //! The substring `data`, and the Buffer it lies in if any (whose storage out-of-order bytes can share)
+    struct Substring {
+        std::string_view data;
+        const Buffer *storage;
+    };
+
+    //! Receive a substring (all the push_substring overloads come here)
+    void push(const Substring &data, const uint64_t index, const bool eof);
+
+    //! Store as much of [begin, end) as the limit and budget allow, and charge the budget for it
+    void store_within_budget(const Substring &data, const uint64_t index, const uint64_t begin, uint64_t end);
+
+    //! Store the part of `data` (which starts at `index`) that covers [begin, end) and isn't already pending
+    void store(const Substring &data, const uint64_t index, uint64_t begin, uint64_t end);
+
+    //! Write any pending bytes that have become contiguous with the output,
+    //! after the bytes from `written_from` onward were written to it directly
+    void flush(const uint64_t written_from);
+
+    //! \name Backend::Bitmap helpers
+    //!@{
+    void store_bitmap(const std::string_view data, const uint64_t index, const uint64_t begin, const uint64_t end);
+    void flush_bitmap(const uint64_t written_from);
+
+    //! Set (or clear) the occupancy bits for stream indices [begin, end)
+    //! \returns the number of bits that changed
+    size_t mark(const uint64_t begin, const uint64_t end, const bool occupied);
+
+    //! \returns the number of consecutive occupied (or unoccupied) slots starting at stream index `from`, up to `limit`
+    size_t slot_run(const uint64_t from, const size_t limit, const bool occupied) const;
+
+    //! Grow the ring (rehoming the held bytes) until it spans [first_unass_index_, end)
+    void reserve_ring(const uint64_t end);
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
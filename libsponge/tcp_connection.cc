@@ -1,6 +1,8 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -12,6 +14,14 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+//! The smallest shift that lets a 16-bit window field describe the whole receive capacity
+static uint8_t window_scale_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WINDOW_SCALE && (capacity >> shift) > numeric_limits<uint16_t>::max())
+        ++shift;
+    return shift;
+}
+
 size_t TCPConnection::remaining_outbound_capacity() const { return sender_.stream_in().remaining_capacity(); }
 
 size_t TCPConnection::bytes_in_flight() const { return sender_.bytes_in_flight(); }
@@ -20,7 +30,27 @@ size_t TCPConnection::unassembled_bytes() const { return receiver_.unassembled_b
 
 size_t TCPConnection::time_since_last_segment_received() const { return time_current_ - time_last_received_; }
 
-void TCPConnection::segment_received(const TCPSegment &seg) {
+optional<uint64_t> TCPConnection::next_timeout() const {
+    if (!active_)
+        return {};
+    optional<uint64_t> timeout = sender_.next_timeout();
+    if (ack_deadline_.has_value()) {
+        const uint64_t ack_left = ack_deadline_.value() - min(ack_deadline_.value(), time_current_);
+        timeout = min(timeout.value_or(ack_left), ack_left);
+    }
+    if (linger_after_streams_finish_ && streams_finished()) {
+        const uint64_t linger = 10 * cfg_.rt_timeout;
+        const uint64_t linger_left = linger - min<uint64_t>(linger, time_since_last_segment_received());
+        timeout = min(timeout.value_or(linger_left), linger_left);
+    }
+    return timeout;
+}
+
+size_t TCPConnection::fast_retransmissions() const { return sender_.fast_retransmissions(); }
+
+size_t TCPConnection::timeout_retransmissions() const { return sender_.timeout_retransmissions(); }
+
+void TCPConnection::segment_received(const TCPSegment &seg, const vector<Buffer> &more_payload) {
     // Step 0: update last received segment time
     time_last_received_ = time_current_;
     // Step 1: check if RST flag is set:
@@ -28,8 +58,31 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 	rst_handler();
 	return;
     }
+    if (!check_timestamps(seg)) {
+        // a segment that failed PAWS still gets an acknowledgment, in case the peer needs one
+        if (seg.header().timestamps.has_value() && seg.length_in_sequence_space() > 0) {
+            sender_.send_empty_segment();
+            send(false);
+        }
+        return;
+    }
     // Otherwise, give the segment to the TCPReciver
-    receiver_.segment_received(seg);
+    const optional<WrappingInt32> expected_seqno = receiver_.ackno();
+    const bool had_gap = receiver_.unassembled_bytes() > 0;
+    receiver_.segment_received(seg, more_payload);
+    bytes_unacknowledged_ += seg.payload().size();
+    for (const auto &payload : more_payload)
+        bytes_unacknowledged_ += payload.size();
+    const bool in_order = expected_seqno.has_value() && seg.header().seqno == expected_seqno.value() &&
+                          !had_gap && receiver_.unassembled_bytes() == 0;
+    if (seg.header().syn && seg.header().sack_permitted && cfg_.sack)
+        sack_enabled_ = true;
+    update_mss();
+    if (seg.header().syn && seg.header().window_scale.has_value() && cfg_.window_scaling) {
+        window_scaling_enabled_ = true;
+        send_window_scale_ = min(seg.header().window_scale.value(), TCPHeader::MAX_WINDOW_SCALE);
+        receive_window_scale_ = window_scale_for(cfg_.recv_capacity);
+    }
 
     // if inbound stream ends before outbound stream has reached EOF, linger... = false
     // should check fin_sent() because the logic here is that the remote peer closes its 
@@ -40,7 +93,15 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     bool replied = false;
     // If ACK flag is set, tells the TCPSender about ackno and window_size
     if (seg.header().ack) {
-        sender_.ack_received(seg.header().ackno, seg.header().win);
+        // the window in a SYN segment is never scaled
+        const uint32_t window = seg.header().syn ? seg.header().win : uint32_t{seg.header().win} << send_window_scale_;
+        // the peer echoes our clock back, which times whichever transmission it is acknowledging
+        optional<uint64_t> measured_rtt;
+        if (timestamps_enabled_)
+            measured_rtt = static_cast<uint32_t>(static_cast<uint32_t>(time_current_) -
+                                                 seg.header().timestamps->echo_reply);
+        sender_.ack_received(
+            seg.header().ackno, window, seg.length_in_sequence_space() == 0, seg.header().sack, measured_rtt);
 	if (sender_.next_seqno_absolute() > 0) {
 	    sender_.fill_window();
 	    replied = send(false);
@@ -49,13 +110,24 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     // If seg occupies any sequence numbers, make sure at least one seg is sent in reply
     if (seg.length_in_sequence_space() > 0 && (!replied)) {
 	sender_.fill_window();
-	if (!send(false))
+	if (!send(false) && !delay_ack(seg, in_order))
             sender_.send_empty_segment();
 	send(false);
     }
     done();
 }
 
+bool TCPConnection::delay_ack(const TCPSegment &seg, const bool in_order) {
+    // out-of-order data gets a duplicate ack (or a filled gap an ack) at once, for fast retransmit;
+    // SYN and FIN aren't delayed, and neither is a second full-sized segment's worth of data
+    if (!cfg_.delayed_ack || !in_order || seg.header().syn || seg.header().fin ||
+        bytes_unacknowledged_ >= 2 * TCPConfig::MAX_PAYLOAD_SIZE)
+        return false;
+    if (!ack_deadline_.has_value())
+        ack_deadline_ = time_current_ + cfg_.ack_delay;
+    return true;
+}
+
 bool TCPConnection::active() const { return active_; }
 
 size_t TCPConnection::write(const string &data) {
@@ -66,6 +138,14 @@ size_t TCPConnection::write(const string &data) {
     return bytes_written;
 }
 
+size_t TCPConnection::write(string &&data) {
+    auto bytes_written = sender_.stream_in().write(move(data));
+    sender_.fill_window();
+    send(false);
+    done();
+    return bytes_written;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
     // Step 0: update the current time
@@ -82,6 +162,10 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
 	return;
     }    
 
+    // a delayed acknowledgment that is due goes out now, unless a retransmission carries it
+    if (ack_deadline_.has_value() && time_current_ >= ack_deadline_.value() && sender_.segments_out().empty())
+        sender_.send_empty_segment();
+
     // may need to retransmit
     // because tcp sender put un-acked segments in the queue again
     send(false);
@@ -90,6 +174,18 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
     done();
 }
 
+void TCPConnection::cork() { sender_.set_corked(true); }
+
+void TCPConnection::uncork() {
+    sender_.set_corked(false);
+    // (before connect(), there's nothing to send, and filling the window would send a SYN)
+    if (sender_.next_seqno_absolute() > 0) {
+        sender_.fill_window();
+        send(false);
+    }
+    done();
+}
+
 // Shut down the outbound byte stream
 void TCPConnection::end_input_stream() {
     sender_.stream_in().end_input();
@@ -127,10 +223,10 @@ bool TCPConnection::send(bool rst) {
     bool sent = false;
     while (!sender_.segments_out().empty()) {
 	sent = true;
-        auto segment = sender_.segments_out().front();
+        // segments are moved along, so their payloads' reference counts are left alone
+        segments_out_.push(move(sender_.segments_out().front()));
 	sender_.segments_out().pop();
-	fill_header(segment.header(), rst);
-	segments_out_.push(segment);
+	fill_header(segments_out_.back().header(), rst);
     }
     return sent;
 }
@@ -140,27 +236,79 @@ void TCPConnection::fill_header(TCPHeader& header, bool rst) {
     if (receiver_.ackno().has_value()) {
         header.ackno = receiver_.ackno().value();
 	header.ack = true;
+	last_ack_sent_ = header.ackno;
+	bytes_unacknowledged_ = 0;
+	ack_deadline_.reset();
     }
-    // fill in window size
-    if (receiver_.window_size() <= numeric_limits<uint16_t>::max())
-        header.win = receiver_.window_size();
+    // fill in window size, scaled unless this is a SYN
+    const size_t window = receiver_.advertise_window() >> (header.syn ? 0 : receive_window_scale_);
+    if (window <= numeric_limits<uint16_t>::max())
+        header.win = window;
     else
 	header.win = numeric_limits<uint16_t>::max();
+    // like SACK-permitted, the window scale goes on our SYN or on the SYN-ACK to a SYN that had it
+    header.window_scale.reset();
+    if (header.syn && cfg_.window_scaling && (window_scaling_enabled_ || !receiver_.ackno().has_value()))
+        header.window_scale = window_scale_for(cfg_.recv_capacity);
+    // timestamps go on our SYN, the SYN-ACK to a SYN that had them, and every segment once negotiated
+    header.timestamps.reset();
+    if (timestamps_enabled_ || (header.syn && cfg_.timestamps && !receiver_.ackno().has_value()))
+        header.timestamps = TCPHeader::Timestamps{static_cast<uint32_t>(time_current_), header.ack ? ts_recent_ : 0};
+    // SACK-permitted goes on our SYN, or on the SYN-ACK if the peer's SYN had it
+    header.sack_permitted = header.syn && cfg_.sack && (sack_enabled_ || !receiver_.ackno().has_value());
+    if (sack_enabled_ && header.ack)
+        header.sack = receiver_.sack_blocks();
     // Set rst
     header.rst = rst;
 }
 
+void TCPConnection::update_mss() {
+    // (timestamps go on every segment once negotiated, and SACK blocks on every one with an ACK)
+    TCPHeader options;
+    if (timestamps_enabled_)
+        options.timestamps = TCPHeader::Timestamps{};
+    if (sack_enabled_)
+        options.sack = receiver_.sack_blocks();
+    sender_.set_mss(TCPConfig::MAX_PAYLOAD_SIZE - (options.data_offset() * 4u - TCPHeader::LENGTH));
+}
+
+bool TCPConnection::check_timestamps(const TCPSegment &seg) {
+    const TCPHeader &header = seg.header();
+    if (header.syn && header.timestamps.has_value() && cfg_.timestamps) {
+        timestamps_enabled_ = true;
+        ts_recent_ = header.timestamps->value;
+        return true;
+    }
+    if (!timestamps_enabled_)
+        return true;
+    // once negotiated, every segment should carry timestamps (RFC 7323 section 3.2)
+    if (!header.timestamps.has_value())
+        return false;
+    // PAWS: a timestamp older than the last one is from a segment that wandered for a whole wrap
+    const uint32_t value = header.timestamps->value;
+    if (static_cast<int32_t>(value - ts_recent_) < 0)
+        return false;
+    // echo the timestamp of the segment that advances the window, not of later ones (RFC 7323 section 4.3)
+    if (header.seqno - last_ack_sent_ <= 0)
+        ts_recent_ = value;
+    return true;
+}
+
 void TCPConnection::rst_handler() {
     receiver_.stream_out().set_error();
     sender_.stream_in().set_error();
     active_ = false;
 }
 
-void TCPConnection::done() {
+bool TCPConnection::streams_finished() const {
     bool prereq1 = (receiver_.stream_out().input_ended() && receiver_.unassembled_bytes() == 0);
     bool prereq2 = sender_.fin_sent();
     bool prereq3 = (sender_.bytes_in_flight() == 0);
-    bool done = prereq1 && prereq2 && prereq3;
+    return prereq1 && prereq2 && prereq3;
+}
+
+void TCPConnection::done() {
+    bool done = streams_finished();
     bool timeout = time_since_last_segment_received() >= 10 * cfg_.rt_timeout;
     if (done && ((!linger_after_streams_finish_) || timeout))
         active_ = false;
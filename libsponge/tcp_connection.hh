@@ -10,8 +10,9 @@
 class TCPConnection {
   private:
     TCPConfig cfg_;
-    TCPReceiver receiver_{cfg_.recv_capacity};
-    TCPSender sender_{cfg_.send_capacity, cfg_.rt_timeout, cfg_.fixed_isn};
+    TCPReceiver receiver_{
+        cfg_.recv_capacity, cfg_.recv_budget, cfg_.recv_unassembled_limit, cfg_.recv_budget_policy};
+    TCPSender sender_{cfg_};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> segments_out_{};
@@ -24,6 +25,42 @@ class TCPConnection {
     //! Is the connection alive?
     bool active_{true};
 
+    //! Did both SYNs carry SACK-permitted?
+    bool sack_enabled_{false};
+
+    //! \name Window scaling (RFC 7323), if both SYNs carried the option
+    //!@{
+    bool window_scaling_enabled_{false};
+    uint8_t send_window_scale_{0};     //!< shift for the windows the peer advertises
+    uint8_t receive_window_scale_{0};  //!< shift for the windows we advertise
+    //!@}
+
+    //! \name Timestamps (RFC 7323), if both SYNs carried the option; our clock is time_current_
+    //!@{
+    bool timestamps_enabled_{false};
+    uint32_t ts_recent_{0};           //!< the peer's TSval to echo
+    WrappingInt32 last_ack_sent_{0};  //!< the ackno of our latest segment, which decides when ts_recent_ changes
+    //!@}
+
+    //! \name Delayed acknowledgments, if cfg_.delayed_ack; any segment we send carries the acknowledgment
+    //!@{
+    size_t bytes_unacknowledged_{0};        //!< payload received since our last acknowledgment
+    std::optional<size_t> ack_deadline_{};  //!< when a delayed acknowledgment is due, by time_current_
+    //!@}
+
+    //! \brief Decide whether the acknowledgment `seg` needs can wait (and set its deadline if so)
+    //! \param in_order whether `seg` arrived in order, neither leaving nor filling a gap
+    //! \returns true if the acknowledgment is delayed
+    bool delay_ack(const TCPSegment &seg, const bool in_order);
+
+    //! \brief Size the sender's segments so that the options fill_header() adds still fit in a datagram
+    //! \note the SACK blocks change only as segments arrive, so this follows each one
+    void update_mss();
+
+    //! \brief Check a segment's timestamp (PAWS) and remember it for echoing
+    //! \returns false if the segment must be dropped
+    bool check_timestamps(const TCPSegment &seg);
+
     //! timer
     size_t time_current_{0};
     size_t time_last_received_{0};
@@ -39,11 +76,24 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write data to the outbound byte stream without copying it, and send it over TCP if possible
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(std::string &&data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Hold back small segments (like TCP_CORK): until uncork(), writes only go out in full-sized segments
+    void cork();
+
+    //! \brief Stop holding back small segments, and send what's been held back
+    void uncork();
+
+    //! \returns whether the connection is corked
+    bool corked() const { return sender_.corked(); }
     //!@}
 
     //! \name "Output" interface for the reader
@@ -62,6 +112,12 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief segments retransmitted because of duplicate acks
+    size_t fast_retransmissions() const;
+    //! \brief segments retransmitted because the retransmission timer expired
+    size_t timeout_retransmissions() const;
+    //! \brief the most payload bytes in a wire segment (the size to split super-segments into)
+    size_t mss() const { return sender_.mss(); }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {sender_, receiver_, active(), linger_after_streams_finish_}; };
     //!@}
@@ -70,11 +126,23 @@ class TCPConnection {
     //!@{
 
     //! Called when a new segment has been received from the network
-    void segment_received(const TCPSegment &seg);
+    void segment_received(const TCPSegment &seg) { segment_received(seg, {}); }
+
+    //! \brief Called when a run of in-order segments has been received, merged into one (see SegmentCoalescer)
+    //! \details `seg` is the run's header and first payload, and `more_payload` the rest of its payloads;
+    //! the run is acknowledged as the one segment it adds up to.
+    void segment_received(const TCPSegment &seg, const std::vector<Buffer> &more_payload);
 
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Milliseconds from now until tick() has something to do (retransmit, pace out data, send a
+    //! delayed acknowledgment, or end lingering), or nothing if the connection only needs a tick
+    //! before its next segment or write.
+    //! \note An owner with many connections can keep a deadline for each one in a shared TimerWheel
+    //! instead of ticking them all; a late tick(), covering all the time missed, catches a connection up.
+    std::optional<uint64_t> next_timeout() const;
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
@@ -112,6 +180,9 @@ class TCPConnection {
     //! handle the RST flag
     void rst_handler();
 
+    //! have both streams finished, with nothing left in flight?
+    bool streams_finished() const;
+
     //! connection done?
     void done();
 };
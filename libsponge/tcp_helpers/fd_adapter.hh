@@ -55,7 +55,7 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     std::optional<TCPSegment> read();
 
     //! Writes a TCP segment into a UDP payload
-    void write(TCPSegment &seg);
+    void write(TCPSegment &&seg);
 
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
@@ -49,11 +49,11 @@ class LossyFdAdapter {
 
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
     //! \param[in] seg is the packet to either write or drop
-    void write(TCPSegment &seg) {
+    void write(TCPSegment &&seg) {
         if (_should_drop(true)) {
             return;
         }
-        return _adapter.write(seg);
+        return _adapter.write(std::move(seg));
     }
 
     //! \name
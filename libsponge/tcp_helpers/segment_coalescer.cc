@@ -0,0 +1,68 @@
+#include "segment_coalescer.hh"
+
+#include "tcp_config.hh"
+
+#include <utility>
+
+using namespace std;
+
+string CoalescedSegment::payload() const {
+    string ret{segment.payload().str()};
+    for (const auto &buf : more_payload) {
+        ret.append(buf.str());
+    }
+    return ret;
+}
+
+bool SegmentCoalescer::_continues_held(const TCPSegment &seg) const {
+    if (not _held.has_value()) {
+        return false;
+    }
+    const TCPHeader &held = _held->segment.header();
+    const TCPHeader &next = seg.header();
+
+    // only data continues a run, and a SYN, RST, URG, FIN or PSH can't be in the middle of one
+    if (seg.payload().size() == 0 or _held_size == 0 or next.syn or next.rst or next.urg or held.syn or
+        held.rst or held.urg or held.fin or held.psh) {
+        return false;
+    }
+    // (a merged segment is no bigger than a super-segment)
+    if (_held_size + seg.payload().size() > TCPConfig::MAX_OFFLOAD_PAYLOAD) {
+        return false;
+    }
+    if (next.seqno != held.seqno + _held_size) {
+        return false;
+    }
+    return next.sport == held.sport and next.dport == held.dport and next.ack == held.ack and
+           next.ackno == held.ackno and next.win == held.win and next.window_scale == held.window_scale and
+           next.timestamps == held.timestamps and next.sack_permitted == held.sack_permitted and
+           next.sack == held.sack;
+}
+
+void SegmentCoalescer::_release_held() {
+    if (not _held.has_value()) {
+        return;
+    }
+    _segments_out.push(move(_held.value()));
+    _held.reset();
+    _held_size = 0;
+}
+
+//! \param[in] seg the segment that arrived after all those pushed so far
+void SegmentCoalescer::push(TCPSegment &&seg) {
+    if (_continues_held(seg)) {
+        // the run ends as the last segment does
+        TCPHeader &held = _held->segment.header();
+        held.fin = seg.header().fin;
+        held.psh = seg.header().psh;
+        _held_size += seg.payload().size();
+        _held->more_payload.push_back(move(seg.payload()));
+        ++_merged;
+        return;
+    }
+    _release_held();
+    _held_size = seg.payload().size();
+    _held = CoalescedSegment{move(seg), {}};
+}
+
+void SegmentCoalescer::flush() { _release_held(); }
@@ -0,0 +1,59 @@
+#ifndef SPONGE_LIBSPONGE_SEGMENT_COALESCER_HH
+#define SPONGE_LIBSPONGE_SEGMENT_COALESCER_HH
+
+#include "buffer.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <optional>
+#include <queue>
+#include <string>
+#include <vector>
+
+//! \brief A run of in-order segments merged into one, without copying their payloads
+struct CoalescedSegment {
+    TCPSegment segment{};                //!< the first segment, ending (FIN and PSH) as the last one does
+    std::vector<Buffer> more_payload{};  //!< the payloads of the others, in order
+
+    //! \brief The merged segment's payload, as one string (a copy)
+    std::string payload() const;
+};
+
+//! \brief Merges runs of in-order TCP segments before the receiver sees them, like generic receive offload
+//! \details The segments of a batch (e.g., those read in one pass of an event loop) are pushed in the
+//! order they arrived. A segment joins the one before it if it continues it exactly: the same ports,
+//! acknowledgment, window and options, and the next seqno, with neither one a SYN, RST or URG and the
+//! earlier one not a FIN or PSH (which end a run). Anything else, such as an out-of-order, duplicate
+//! or empty segment, passes through as it is, so the order of the batch is kept.
+//!
+//! The payloads of a run aren't concatenated: TCPConnection::segment_received takes the run's header
+//! once, and the payloads one after another.
+class SegmentCoalescer {
+  private:
+    std::optional<CoalescedSegment> _held{};  //!< the run that the next segment may join
+    size_t _held_size{0};                     //!< payload bytes of `_held`
+
+    std::queue<CoalescedSegment> _segments_out{};
+    size_t _merged{0};
+
+    //! Can `seg` join the held run?
+    bool _continues_held(const TCPSegment &seg) const;
+
+    //! Queue the held run
+    void _release_held();
+
+  public:
+    //! \brief Add the next segment of the batch
+    void push(TCPSegment &&seg);
+
+    //! \brief End the batch: everything pushed is now in segments_out()
+    void flush();
+
+    //! \brief Merged segments, in order (complete after flush())
+    std::queue<CoalescedSegment> &segments_out() { return _segments_out; }
+
+    //! \brief How many segments have been merged into the one before them
+    size_t merged() const { return _merged; }
+};
+
+#endif  // SPONGE_LIBSPONGE_SEGMENT_COALESCER_HH
@@ -2,10 +2,13 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "congestion_control.hh"
+#include "reassembly_budget.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <optional>
 
 //! Config for TCP sender and receiver
@@ -13,6 +16,8 @@ class TCPConfig {
   public:
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
     static constexpr size_t MAX_PAYLOAD_SIZE = 1452;   //!< Max TCP payload that fits in either IPv4 or UDP datagram
+    //! Max payload of a super-segment (with `segmentation_offload`): as many full segments as fit in 64 KiB
+    static constexpr size_t MAX_OFFLOAD_PAYLOAD = 64 * 1024 / MAX_PAYLOAD_SIZE * MAX_PAYLOAD_SIZE;
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
 
@@ -20,6 +25,45 @@ class TCPConfig {
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+
+    //! Compute the retransmission timeout from measured RTTs (RFC 6298), starting from `rt_timeout`
+    bool adaptive_rto = false;
+    unsigned int rto_min = 200;    //!< Lowest adaptive retransmission timeout, in milliseconds
+    unsigned int rto_max = 60000;  //!< Highest adaptive (or backed-off adaptive) timeout, in milliseconds
+
+    //! Retransmit after three duplicate acks and recover without waiting for the timer (RFC 5681, RFC 6582)
+    bool fast_retransmit = false;
+    //! Negotiate selective acknowledgments (RFC 2018), so fast recovery can resend every hole at once
+    bool sack = false;
+    //! Negotiate window scaling (RFC 7323), so that windows can be larger than 64 KiB
+    bool window_scaling = false;
+    //! Negotiate timestamps (RFC 7323): an RTT sample from every ack, and protection against
+    //! wrapped sequence numbers (PAWS)
+    bool timestamps = false;
+    //! Delay acknowledgments (RFC 1122 section 4.2.3.2): acknowledge every second full-sized segment,
+    //! or once `ack_delay` has passed, but at once for anything out of order
+    bool delayed_ack = false;
+    unsigned int ack_delay = 40;  //!< Longest an acknowledgment is delayed, in milliseconds (under 500)
+    //! Nagle's algorithm (RFC 896): while data is unacknowledged, hold back a segment smaller
+    //! than MAX_PAYLOAD_SIZE until there's enough to fill one, or everything has been acknowledged
+    bool nagle = false;
+    //! Like TCP segmentation offload: send super-segments of up to MAX_OFFLOAD_PAYLOAD bytes, which
+    //! the owner splits into MAX_PAYLOAD_SIZE pieces (with TCPSegment::split) only as they leave for the wire
+    bool segmentation_offload = false;
+
+    //! Congestion control for the sender (none by default)
+    CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;
+    //! Pace new segments at this rate, in bytes per second (0 for the congestion control's rate, if any)
+    double pacing_rate = 0;
+    //! Most bytes a paced sender saves up while idle, and sends back to back
+    size_t pacing_burst = 2 * MAX_PAYLOAD_SIZE;
+
+    //! Most bytes the receiver holds out of order, beyond what `recv_budget` allows
+    size_t recv_unassembled_limit = std::numeric_limits<size_t>::max();
+    //! Out-of-order bytes budget shared with other receivers (nullptr for none)
+    ReassemblyBudget *recv_budget = &ReassemblyBudget::global();
+    //! What the receiver does when it's out of budget
+    ReassemblyBudget::Policy recv_budget_policy = ReassemblyBudget::Policy::DropNewest;
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +74,10 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    //! Read every datagram waiting in one event-loop pass, and merge runs of in-order segments
+    //! before the TCPConnection sees them (with a SegmentCoalescer, like generic receive offload)
+    bool coalesce_segments = false;
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
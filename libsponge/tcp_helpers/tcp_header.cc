@@ -1,9 +1,23 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+namespace {
+//! \name TCP option kinds
+//!@{
+constexpr uint8_t OPT_EOL = 0;
+constexpr uint8_t OPT_NOP = 1;
+constexpr uint8_t OPT_WINDOW_SCALE = 3;
+constexpr uint8_t OPT_SACK_PERMITTED = 4;
+constexpr uint8_t OPT_SACK = 5;
+constexpr uint8_t OPT_TIMESTAMPS = 8;
+//!@}
+constexpr size_t SACK_BLOCK_LENGTH = 8;
+}  // namespace
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -37,8 +51,54 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    window_scale.reset();
+    timestamps.reset();
+    sack_permitted = false;
+    sack.clear();
+    size_t options_left = doff * 4 - TCPHeader::LENGTH;
+    while (options_left > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        --options_left;
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            continue;
+        }
+
+        // every other option has a length that counts its kind and length bytes;
+        // if it's malformed, ignore the rest of the options
+        if (options_left == 0) {
+            break;
+        }
+        const uint8_t len = p.u8();
+        --options_left;
+        if (len < 2 or len - 2u > options_left) {
+            break;
+        }
+        options_left -= len - 2;
+        size_t body = len - 2;
+        if (kind == OPT_WINDOW_SCALE and body == 1) {
+            window_scale = p.u8();
+        } else if (kind == OPT_TIMESTAMPS and body == 8) {
+            const uint32_t value = p.u32();
+            const uint32_t echo_reply = p.u32();
+            timestamps = Timestamps{value, echo_reply};
+        } else if (kind == OPT_SACK_PERMITTED and body == 0) {
+            sack_permitted = true;
+        } else if (kind == OPT_SACK and body % SACK_BLOCK_LENGTH == 0) {
+            for (; body > 0; body -= SACK_BLOCK_LENGTH) {
+                const WrappingInt32 left{p.u32()};
+                const WrappingInt32 right{p.u32()};
+                sack.push_back({left, right});
+            }
+        } else {
+            p.remove_prefix(body);
+        }
+    }
+
+    // skip whatever is left of the header
+    p.remove_prefix(options_left);
 
     if (p.error()) {
         return p.get_error();
@@ -47,6 +107,24 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
+//! \returns how many of `count` SACK blocks fit after `options_before` bytes of other options
+static size_t sack_blocks_fitting(const size_t count, const size_t options_before) {
+    return min(count, (TCPHeader::MAX_OPTIONS_LENGTH - options_before - 4) / SACK_BLOCK_LENGTH);
+}
+
+//! \returns the header length in 32-bit words, as serialize() writes it
+uint8_t TCPHeader::data_offset() const {
+    // (the same options, in the same sizes, as serialize() writes)
+    size_t options = 0;
+    options += window_scale.has_value() ? 4 : 0;
+    options += timestamps.has_value() ? 12 : 0;
+    options += sack_permitted ? 4 : 0;
+    if (not sack.empty()) {
+        options += 4 + sack_blocks_fitting(sack.size(), options) * SACK_BLOCK_LENGTH;
+    }
+    return max<size_t>(doff, (LENGTH + options + 3) / 4);
+}
+
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
 string TCPHeader::serialize() const {
     // sanity check
@@ -54,14 +132,48 @@ string TCPHeader::serialize() const {
         throw runtime_error("TCP header too short");
     }
 
+    string options;
+    if (window_scale.has_value()) {
+        NetUnparser::u8(options, OPT_NOP);
+        NetUnparser::u8(options, OPT_WINDOW_SCALE);
+        NetUnparser::u8(options, 3);
+        NetUnparser::u8(options, window_scale.value());
+    }
+    if (timestamps.has_value()) {
+        NetUnparser::u8(options, OPT_NOP);
+        NetUnparser::u8(options, OPT_NOP);
+        NetUnparser::u8(options, OPT_TIMESTAMPS);
+        NetUnparser::u8(options, 10);
+        NetUnparser::u32(options, timestamps->value);
+        NetUnparser::u32(options, timestamps->echo_reply);
+    }
+    if (sack_permitted) {
+        NetUnparser::u8(options, OPT_NOP);
+        NetUnparser::u8(options, OPT_NOP);
+        NetUnparser::u8(options, OPT_SACK_PERMITTED);
+        NetUnparser::u8(options, 2);
+    }
+    if (not sack.empty()) {
+        const size_t blocks = sack_blocks_fitting(sack.size(), options.size());
+        NetUnparser::u8(options, OPT_NOP);
+        NetUnparser::u8(options, OPT_NOP);
+        NetUnparser::u8(options, OPT_SACK);
+        NetUnparser::u8(options, 2 + blocks * SACK_BLOCK_LENGTH);
+        for (size_t i = 0; i < blocks; ++i) {
+            NetUnparser::u32(options, sack[i].left.raw_value());
+            NetUnparser::u32(options, sack[i].right.raw_value());
+        }
+    }
+    const uint8_t header_words = data_offset();
+
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(4 * header_words);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, header_words << 4);   // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
@@ -72,7 +184,8 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    ret.append(options);
+    ret.resize(4 * header_words, OPT_EOL);  // pad (or expand) the header to its advertised size
 
     return ret;
 }
@@ -89,14 +202,33 @@ string TCPHeader::to_string() const {
        << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP window scale: " << (window_scale.has_value() ? std::to_string(*window_scale) : "none") << '\n'
+       << "TCP timestamps: "
+       << (timestamps.has_value() ? std::to_string(timestamps->value) + "/" + std::to_string(timestamps->echo_reply)
+                                  : "none")
+       << '\n'
+       << "TCP SACK-permitted: " << sack_permitted << '\n';
+    for (const auto &block : sack) {
+        ss << "TCP SACK block: " << block.left << "-" << block.right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps->value << "/" << timestamps->echo_reply;
+    }
+    for (const auto &block : sack) {
+        ss << ",sack=" << block.left << "-" << block.right;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +236,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && window_scale == other.window_scale && timestamps == other.timestamps &&
+           sack_permitted == other.sack_permitted && sack == other.sack;
 }
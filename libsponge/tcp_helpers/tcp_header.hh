@@ -4,10 +4,34 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Of the TCP options, only window scale and timestamps (RFC 7323), SACK-permitted and SACK
+//! (RFC 2018) are supported; others are skipped
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;              //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;  //!< the most option bytes `doff` can describe
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;   //!< the largest shift count allowed (RFC 7323)
+
+    //! \brief A SACK block: the receiver holds the sequence numbers [left, right)
+    struct SackBlock {
+        WrappingInt32 left;
+        WrappingInt32 right;
+
+        bool operator==(const SackBlock &other) const { return left == other.left and right == other.right; }
+    };
+
+    //! \brief The timestamps option: the sender's clock, and the peer's clock echoed back
+    struct Timestamps {
+        uint32_t value;       //!< TSval: the sender's clock when it sent the segment
+        uint32_t echo_reply;  //!< TSecr: the most recent TSval from the peer (meaningful with ACK)
+
+        bool operator==(const Timestamps &other) const {
+            return value == other.value and echo_reply == other.echo_reply;
+        }
+    };
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,12 +74,24 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //! \note serialize() grows the header beyond `doff` to fit them (see data_offset())
+    //!@{
+    std::optional<uint8_t> window_scale{};   //!< window scale option's shift count (meaningful on SYN segments)
+    std::optional<Timestamps> timestamps{};  //!< timestamps option (on every segment, once negotiated)
+    bool sack_permitted = false;             //!< SACK-permitted option (meaningful on SYN segments)
+    std::vector<SackBlock> sack{};           //!< SACK blocks, the most recent first (as many as fit are serialized)
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! The data offset that serialize() writes: `doff`, or more if the options need it
+    uint8_t data_offset() const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -13,7 +13,7 @@ class TCPOverIPv4Adapter : public FdAdapterBase {
   public:
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
-    InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+    InternetDatagram wrap_tcp_in_ip(TCPSegment &&seg);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
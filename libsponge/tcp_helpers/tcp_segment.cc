@@ -3,20 +3,25 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <stdexcept>
 #include <variant>
 
 using namespace std;
 
+//! Where the checksum sits in a serialized TCP header
+static constexpr size_t CHECKSUM_OFFSET = 16;
+
 //! \param[in] buffer string/Buffer to be parsed
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
+ParseResult TCPSegment::parse(Buffer buffer, const uint32_t datagram_layer_checksum) {
     InternetChecksum check(datagram_layer_checksum);
     check.add(buffer);
     if (check.value()) {
         return ParseResult::BadChecksum;
     }
 
-    NetParser p{buffer};
+    NetParser p{move(buffer)};
     _header.parse(p);
     _payload = p.buffer();
     return p.get_error();
@@ -27,19 +32,63 @@ size_t TCPSegment::length_in_sequence_space() const {
 }
 
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    TCPHeader header_out = _header;
-    header_out.cksum = 0;
+string TCPSegment::_serialize_header(const uint32_t datagram_layer_checksum) const {
+    // serialize the header once, with a zero checksum, and fill in the checksum taken over the entire segment
+    string header_out = _header.serialize();
+    header_out[CHECKSUM_OFFSET] = header_out[CHECKSUM_OFFSET + 1] = 0;
 
-    // calculate checksum -- taken over entire segment
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
+    check.add(header_out);
     check.add(_payload);
-    header_out.cksum = check.value();
+    const uint16_t cksum = check.value();
+    header_out[CHECKSUM_OFFSET] = static_cast<char>(cksum >> 8);
+    header_out[CHECKSUM_OFFSET + 1] = static_cast<char>(cksum & 0xff);
+    return header_out;
+}
 
-    BufferList ret;
-    ret.append(header_out.serialize());
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const & {
+    BufferList ret{_serialize_header(datagram_layer_checksum)};
     ret.append(_payload);
+    return ret;
+}
 
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) && {
+    BufferList ret{_serialize_header(datagram_layer_checksum)};
+    ret.append(move(_payload));
     return ret;
 }
+
+//! \param[in] max_payload the most payload a piece may carry
+//! \returns the pieces, in sequence order (just a copy of this segment if it isn't too big)
+vector<TCPSegment> TCPSegment::split(const size_t max_payload) const {
+    if (max_payload == 0) {
+        throw invalid_argument("TCPSegment::split: max_payload must be positive");
+    }
+
+    const size_t size = _payload.size();
+    vector<TCPSegment> pieces;
+    pieces.reserve(max<size_t>(1, (size + max_payload - 1) / max_payload));
+
+    size_t offset = 0;
+    do {
+        const size_t length = min(max_payload, size - offset);
+        const bool first = offset == 0;
+        const bool last = offset + length == size;
+
+        TCPSegment &piece = pieces.emplace_back();
+        piece._header = _header;
+        piece._header.seqno = _header.seqno + (first ? 0 : uint32_t(offset + _header.syn));
+        piece._header.syn = _header.syn and first;
+        piece._header.fin = _header.fin and last;
+        piece._header.psh = _header.psh and last;
+        piece._payload = _payload;
+        piece._payload.remove_prefix(offset);
+        piece._payload.remove_suffix(size - offset - length);
+
+        offset += length;
+    } while (offset < size);
+
+    return pieces;
+}
@@ -5,6 +5,8 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
@@ -12,12 +14,18 @@ class TCPSegment {
     TCPHeader _header{};
     Buffer _payload{};
 
+    //! Serialize the header, with the checksum taken over the entire segment
+    std::string _serialize_header(const uint32_t datagram_layer_checksum) const;
+
   public:
     //! \brief Parse the segment from a string
-    ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
+    ParseResult parse(Buffer buffer, const uint32_t datagram_layer_checksum = 0);
 
     //! \brief Serialize the segment to a string
-    BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
+    BufferList serialize(const uint32_t datagram_layer_checksum = 0) const &;
+
+    //! \brief Serialize a segment that is no longer needed, moving its payload into the result
+    BufferList serialize(const uint32_t datagram_layer_checksum = 0) &&;
 
     //! \name Accessors
     //!@{
@@ -31,6 +39,11 @@ class TCPSegment {
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
+
+    //! \brief Split into segments with at most `max_payload` bytes of payload each, sharing this one's storage
+    //! \details As with TCP segmentation offload, every piece has a copy of this header (options and all)
+    //! with its own seqno; only the first keeps SYN, and only the last FIN and PSH.
+    std::vector<TCPSegment> split(const size_t max_payload) const;
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_SEGMENT_HH
@@ -20,6 +20,9 @@ using namespace std;
 
 static constexpr size_t TCP_TICK_MS = 10;
 
+//! Most datagrams read (for a SegmentCoalescer) in one pass of the event loop
+static constexpr size_t MAX_BURST = 64;
+
 //! \param[in] condition is a function returning true if loop should continue
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
@@ -31,6 +34,7 @@ void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
         }
 
         if (_tcp.value().active()) {
+            _sync_cork();
             const auto next_time = timestamp_ms();
             _tcp.value().tick(next_time - base_time);
             _datagram_adapter.tick(next_time - base_time);
@@ -39,6 +43,37 @@ void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     }
 }
 
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_read_burst() {
+    const FileDescriptor &fd = _datagram_adapter;
+    size_t reads = 0;
+    do {
+        auto seg = _datagram_adapter.read();
+        if (seg) {
+            _coalescer.push(move(seg.value()));
+        }
+    } while (++reads < MAX_BURST and fd.readable());
+    _coalescer.flush();
+
+    while (not _coalescer.segments_out().empty() and _tcp->active()) {
+        const CoalescedSegment &run = _coalescer.segments_out().front();
+        _tcp->segment_received(run.segment, run.more_payload);
+        _coalescer.segments_out().pop();
+    }
+    // (a segment after a RST is no use)
+    _coalescer.segments_out() = {};
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_sync_cork() {
+    const bool corked = _corked;
+    if (corked and not _tcp->corked()) {
+        _tcp->cork();
+    } else if (not corked and _tcp->corked()) {
+        _tcp->uncork();
+    }
+}
+
 //! \param[in] data_socket_pair is a pair of connected AF_UNIX SOCK_STREAM sockets
 //! \param[in] datagram_interface is the interface for reading and writing datagrams
 template <typename AdaptT>
@@ -76,9 +111,13 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
+                            if (_datagram_adapter.config().coalesce_segments) {
+                                _read_burst();
+                            } else {
+                                auto seg = _datagram_adapter.read();
+                                if (seg) {
+                                    _tcp->segment_received(move(seg.value()));
+                                }
                             }
 
                             // debugging output:
@@ -96,7 +135,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            // a cork set before these bytes were written applies to them
+            _sync_cork();
+            auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
             const auto amount_written = _tcp->write(move(data));
             if (amount_written != len) {
@@ -129,8 +170,7 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto bytes_written = _thread_data.write(inbound.peek_views(amount_to_write), false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
@@ -155,8 +195,16 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
                         Direction::Out,
                         [&] {
                             while (not _tcp->segments_out().empty()) {
-                                _datagram_adapter.write(_tcp->segments_out().front());
+                                TCPSegment seg = move(_tcp->segments_out().front());
                                 _tcp->segments_out().pop();
+                                // a super-segment (see TCPConfig::segmentation_offload) is split only here
+                                if (seg.payload().size() > _tcp->mss()) {
+                                    for (auto &piece : seg.split(_tcp->mss())) {
+                                        _datagram_adapter.write(move(piece));
+                                    }
+                                } else {
+                                    _datagram_adapter.write(move(seg));
+                                }
                             }
                         },
                         [&] { return not _tcp->segments_out().empty(); });
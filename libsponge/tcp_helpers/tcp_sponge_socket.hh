@@ -6,6 +6,7 @@
 #include "fd_adapter.hh"
 #include "file_descriptor.hh"
 #include "network_interface.hh"
+#include "segment_coalescer.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
 #include "tuntap_adapter.hh"
@@ -55,6 +56,17 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     bool _fully_acked{false};  //!< Has the outbound data been fully acknowledged by the peer?
 
+    std::atomic_bool _corked{false};  //!< Has the owner corked the connection?
+
+    //! Cork or uncork the TCPConnection to match the owner's latest call (on the TCPConnection thread)
+    void _sync_cork();
+
+    //! merges the segments of a burst, if the adapter's config says so
+    SegmentCoalescer _coalescer{};
+
+    //! Read the datagrams waiting (up to a limit), and give the TCPConnection their segments, coalesced
+    void _read_burst();
+
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
     explicit TCPSpongeSocket(AdaptT &&datagram_interface);
@@ -70,6 +82,13 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! Hold back small segments until uncork() (like setting TCP_CORK), so small writes coalesce
+    void cork() { _corked = true; }
+
+    //! Send what cork() held back, and stop holding back small segments
+    //! \note The TCPConnection thread notices within one tick (10 ms)
+    void uncork() { _corked = false; }
+
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
@@ -28,7 +28,7 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     }
 
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    void write(TCPSegment &&seg) { _tun.write(wrap_tcp_in_ip(std::move(seg)).serialize()); }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -61,7 +61,7 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     std::optional<TCPSegment> read();
 
     //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
-    void write(TCPSegment &seg);
+    void write(TCPSegment &&seg);
 
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
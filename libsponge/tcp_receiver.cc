@@ -1,4 +1,8 @@
 #include "tcp_receiver.hh"
+
+#include "tcp_config.hh"
+
+#include <algorithm>
 #include <iostream>
 
 // Dummy implementation of a TCP receiver
@@ -11,8 +15,8 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-void TCPReceiver::segment_received(const TCPSegment &seg) {
-    auto header = seg.header();
+void TCPReceiver::segment_received(const TCPSegment &seg, const vector<Buffer> &more_payload) {
+    const TCPHeader &header = seg.header();
     // step 1: set isn_ if SYN flag is set
     if (header.syn) {
         isn_ = header.seqno;
@@ -28,8 +32,18 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     else
 	stream_index = abs_seqno - 1;
     bool eof = header.fin;
-    auto str = seg.payload().copy();
-    reassembler_.push_substring(str, stream_index, eof);
+    if (seg.payload().size() > 0)
+        last_segment_index_ = stream_index;
+    // straight from the payload: in-order bytes are copied only into the stream, and out-of-order ones
+    // share the payload's storage
+    reassembler_.push_substring(seg.payload(), stream_index, eof && more_payload.empty());
+    stream_index += seg.payload().size();
+    for (size_t i = 0; i < more_payload.size(); ++i) {
+        if (more_payload[i].size() > 0)
+            last_segment_index_ = stream_index;
+        reassembler_.push_substring(more_payload[i], stream_index, eof && i + 1 == more_payload.size());
+        stream_index += more_payload[i].size();
+    }
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const {
@@ -45,5 +59,37 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 size_t TCPReceiver::window_size() const {
     auto first_unacc = reassembler_.stream_out().bytes_read() + capacity_;
     auto first_unass = reassembler_.stream_out().bytes_written();
-    return first_unacc - first_unass;
+    size_t window = first_unacc - first_unass;
+    if (policy_ == ReassemblyBudget::Policy::ShrinkWindow) {
+        // in-order bytes aren't limited by the budget, so there's always room for a segment of them, and the
+        // window never takes back what was advertised before (RFC 793)
+        const size_t room = max(reassembler_.unassembled_bytes() + reassembler_.unassembled_room(),
+                                TCPConfig::MAX_PAYLOAD_SIZE);
+        const size_t advertised = right_edge_ > first_unass ? right_edge_ - first_unass : 0;
+        window = min(window, max(room, advertised));
+    }
+    return window;
+}
+
+size_t TCPReceiver::advertise_window() {
+    const size_t window = window_size();
+    right_edge_ = max(right_edge_, reassembler_.stream_out().bytes_written() + window);
+    return window;
+}
+
+vector<TCPHeader::SackBlock> TCPReceiver::sack_blocks() const {
+    vector<TCPHeader::SackBlock> blocks;
+    if (!isn_set_)
+        return blocks;
+    optional<size_t> latest;
+    for (const auto &[begin, end] : reassembler_.unassembled_ranges()) {
+        // stream index i has absolute sequence number i + 1 (after the SYN)
+        if (begin <= last_segment_index_ && last_segment_index_ < end)
+            latest = blocks.size();
+        blocks.push_back({wrap(begin + 1, isn_), wrap(end + 1, isn_)});
+    }
+    // move the latest block to the front, keeping the others in order
+    if (latest.has_value())
+        rotate(blocks.begin(), blocks.begin() + *latest, blocks.begin() + *latest + 1);
+    return blocks;
 }
@@ -2,11 +2,14 @@
 #define SPONGE_LIBSPONGE_TCP_RECEIVER_HH
 
 #include "byte_stream.hh"
+#include "reassembly_budget.hh"
 #include "stream_reassembler.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <limits>
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -24,12 +27,32 @@ class TCPReceiver {
     WrappingInt32 isn_;
     bool isn_set_;
 
+    //! Whether the window shrinks when out-of-order bytes can't be held
+    ReassemblyBudget::Policy policy_;
+
+    //! Stream index of the first byte of the most recent segment with a payload
+    uint64_t last_segment_index_{0};
+
+    //! Stream index just past the furthest window advertised so far (by advertise_window())
+    uint64_t right_edge_{0};
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : reassembler_(capacity), capacity_(capacity), isn_(0), isn_set_(false) {}
+    //! \param budget out-of-order bytes budget shared with other receivers (or nullptr)
+    //! \param unassembled_limit the most bytes this receiver holds out of order
+    //! \param policy what to do besides dropping bytes when out of budget
+    TCPReceiver(const size_t capacity,
+                ReassemblyBudget *budget = nullptr,
+                const size_t unassembled_limit = std::numeric_limits<size_t>::max(),
+                const ReassemblyBudget::Policy policy = ReassemblyBudget::Policy::DropNewest)
+        : reassembler_(capacity, StreamReassembler::Backend::IntervalMap, budget, unassembled_limit)
+        , capacity_(capacity)
+        , isn_(0)
+        , isn_set_(false)
+        , policy_(policy) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -51,14 +74,38 @@ class TCPReceiver {
     //! the first byte that falls after the window (and will not be
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
+    //!
+    //! With ReassemblyBudget::Policy::ShrinkWindow, the window is also
+    //! limited to the out-of-order bytes held plus those that could still be held,
+    //! but it is never less than one segment, and never shrinks from the right
+    //! of a window that has been advertised.
     size_t window_size() const;
+
+    //! \brief The window size, recorded as sent to the peer
+    //!
+    //! Call this for the window that actually goes on the wire, so that
+    //! later windows don't take it back.
+    size_t advertise_window();
+
+    //! \brief SACK blocks (RFC 2018) for the bytes held out of order
+    //!
+    //! The block holding the most recently received segment comes first, then the
+    //! others in sequence order. Empty if nothing is held out of order.
+    std::vector<TCPHeader::SackBlock> sack_blocks() const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return reassembler_.unassembled_bytes(); }
 
+    //! \brief the reassembler, for its statistics
+    const StreamReassembler &reassembler() const { return reassembler_; }
+
     //! \brief handle an inbound segment
-    void segment_received(const TCPSegment &seg);
+    void segment_received(const TCPSegment &seg) { segment_received(seg, {}); }
+
+    //! \brief handle an inbound segment followed, in sequence, by `more_payload` (e.g., a run merged by a
+    //! SegmentCoalescer); a FIN ends the last of them
+    void segment_received(const TCPSegment &seg, const std::vector<Buffer> &more_payload);
 
     //! \name "Output" interface for the reader
     //!@{
@@ -2,6 +2,8 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <random>
 #include <iostream>
 
@@ -13,12 +15,33 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] congestion_control the congestion-control algorithm to use
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const CongestionControl::Algorithm congestion_control)
     : isn_(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , ackno_(isn_)
-    , initial_retransmission_timeout_{retx_timeout}
-    , stream_(capacity) 
-    , timer_(retx_timeout) {}
+    , stream_(capacity, ByteStream::Storage::Chunked)
+    , timer_(retx_timeout)
+    , cc_(CongestionControl::make(congestion_control, TCPConfig::MAX_PAYLOAD_SIZE)) {}
+
+//! \param[in] cfg supplies the capacity, retransmission timeouts, ISN, congestion control and loss recovery
+TCPSender::TCPSender(const TCPConfig &cfg)
+    : TCPSender(cfg.send_capacity, cfg.rt_timeout, cfg.fixed_isn, cfg.congestion_control) {
+    timer_ = TCPTimer(cfg.rt_timeout, cfg.adaptive_rto, cfg.rto_min, cfg.rto_max);
+    fast_retransmit_ = cfg.fast_retransmit;
+    nagle_ = cfg.nagle;
+    segmentation_offload_ = cfg.segmentation_offload;
+    fixed_pacing_rate_ = cfg.pacing_rate;
+    pacer_ = TokenBucket(cfg.pacing_burst);
+}
+
+double TCPSender::pacing_rate() const {
+    if (fixed_pacing_rate_ > 0)
+        return fixed_pacing_rate_;
+    return cc_ ? cc_->pacing_rate() : 0;
+}
 
 uint64_t TCPSender::bytes_in_flight() const {
     return next_seqno_ - unwrap(ackno_, isn_, next_seqno_); 
@@ -27,36 +50,54 @@ uint64_t TCPSender::bytes_in_flight() const {
 void TCPSender::fill_window() {
     // absolute upper sequence number:
     if (fin_sent_) return;
-    auto window_size = (window_size_ == 0) ? 1 : window_size_;
+    size_t window_size = (window_size_ == 0) ? 1 : window_size_;
+    if (cc_ && window_size_ != 0) {
+        window_size = min(window_size, cc_->cwnd() + recovery_inflation_);
+    }
+    pacer_.set_rate(pacing_rate());
+    // a paced sender keeps to wire-sized segments, so that the pacing stays smooth
+    const size_t max_payload =
+        (segmentation_offload_ && !pacer_.limited()) ? TCPConfig::MAX_OFFLOAD_PAYLOAD / mss_ * mss_ : mss_;
     auto upper_seqno = unwrap(ackno_, isn_, next_seqno_) + window_size;
     while (next_seqno_ < upper_seqno) {
-        auto num_bytes = min(upper_seqno - next_seqno_, TCPConfig::MAX_PAYLOAD_SIZE); 
+        // a paced sender waits for tick() to earn more tokens (the bucket starts empty, but the SYN isn't paced)
+        if (next_seqno_ > 0 && !pacer_.ready()) break;
+        auto num_bytes = min(upper_seqno - next_seqno_, max_payload);
+        if (next_seqno_ > 0 && hold_small_segment(min(num_bytes, stream_.buffer_size())))
+            break;
+        // with super-segments, while acks are still coming, wait for the window to open far enough for a
+        // sizeable one rather than send a wire segment per ack (like Linux's TSO deferral)
+        if (max_payload > mss_ && next_seqno_ > 0 && bytes_in_flight() > 0 &&
+            num_bytes < stream_.buffer_size() && num_bytes < max_payload && num_bytes < window_size / TSO_WIN_DIVISOR)
+            break;
 	bool check_fin = false;
 	if (num_bytes == upper_seqno - next_seqno_) {
 	    check_fin = true;
 	    num_bytes -= (next_seqno_ == 0) ? 1 : 0;
 	}
-        string &&str = stream_.read(num_bytes);
+        Buffer payload = stream_.read_buffer(num_bytes);
 	// now, construct the TCP Header and payload, and then TCPSegment
 	// TCP Header:
 	TCPHeader header;
 	header.seqno = wrap(next_seqno_, isn_);
 	if (next_seqno_ == 0) header.syn = true;
 	if (stream_.eof()) {
-	    if ( !check_fin || num_bytes > str.size())
+	    if ( !check_fin || num_bytes > payload.size())
 	        header.fin = true;
 	}
-        // payload:
-	Buffer payload(move(str));
         // TCPSegment:
 	TCPSegment segment;
         segment.header() = header;
-        segment.payload() = payload;	
-	if (segment.length_in_sequence_space() > 0) {
-	    segments_out_.push(segment);
-	    segments_outstand_.push(segment);
+        segment.payload() = move(payload);
+	const size_t length = segment.length_in_sequence_space();
+	if (length > 0) {
+	    // the scoreboard keeps the payload's storage, not a copy of the segment
+	    segments_outstand_.push_back(
+	        {next_seqno_, next_seqno_ + length, segment.payload(), time_ms_, unwrap(ackno_, isn_, next_seqno_)});
+	    segments_out_.push(move(segment));
+	    pacer_.consume(length);
 	    // update next_seqno_
-	    next_seqno_ += segment.length_in_sequence_space();
+	    next_seqno_ += length;
 	    timer_.start();
 	} else break;
 	if (header.fin) {
@@ -66,13 +107,33 @@ void TCPSender::fill_window() {
     }
 }
 
+//! \details Only a segment that is small for lack of data waits (one the window cuts short doesn't),
+//! and never the last one, which goes out with the FIN.
+bool TCPSender::hold_small_segment(const size_t payload_size) const {
+    if (payload_size >= stream_.buffer_size() && stream_.input_ended())
+        return false;
+    if (payload_size >= mss_ || payload_size < stream_.buffer_size())
+        return false;
+    return corked_ || (nagle_ && bytes_in_flight() > 0);
+}
+
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param pure_ack Whether the acknowledgment came without data, SYN or FIN
+//! \param sack The SACK blocks that came with the acknowledgment
+//! \param measured_rtt The RTT measured by the caller (from the timestamps option), if any
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const uint32_t window_size,
+                             const bool pure_ack,
+                             const vector<TCPHeader::SackBlock> &sack,
+                             const optional<uint64_t> measured_rtt) {
     auto abs_ackno = unwrap(ackno, isn_, next_seqno_);
     if (abs_ackno > next_seqno_) return;
+    const int32_t newly_acked = ackno - ackno_;
+    const bool duplicate =
+        fast_retransmit_ && pure_ack && ackno == ackno_ && window_size == window_size_ && !segments_outstand_.empty();
     if (ackno - ackno_ > 0) {
-	timer_.set_timeout(initial_retransmission_timeout_);
+	timer_.restore_timeout();
 	timer_.reset_timer();
 	if (!segments_outstand_.empty())
 	    timer_.start();
@@ -82,16 +143,72 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     
     window_size_ = window_size;
     // step 1: Look through outstanding segments
+    optional<uint64_t> rtt_sample;
+    optional<CongestionControl::RateSample> rate_sample;
+    bool acked_retransmission = false;
     while (!segments_outstand_.empty()) {
-	auto segment = segments_outstand_.front();
-	auto upper_seqno = segment.header().seqno + segment.length_in_sequence_space();
-	if (ackno_ - upper_seqno >= 0) {
-	    segments_outstand_.pop();
+	// an ack inside a segment (a super-segment whose first pieces arrived) acknowledges its head
+	split_outstanding(0, abs_ackno);
+	const auto &outstanding = segments_outstand_.front();
+	if (outstanding.end <= abs_ackno) {
+	    if (outstanding.retransmissions == 0) {
+	        rtt_sample = time_ms_ - outstanding.sent_at_ms;
+	        if (*rtt_sample > 0)
+	            rate_sample = {outstanding.delivered_at_send, abs_ackno - outstanding.delivered_at_send, *rtt_sample};
+	    } else {
+	        acked_retransmission = true;
+	    }
+	    segments_outstand_.pop_front();
 	}
 	else break;
     }
     if (segments_outstand_.empty()) timer_.stop();
-    // step 2: fill window
+    // Karn's rule: an ack that covers a retransmission is ambiguous, even for the segments after it
+    // (they may have waited at the receiver for the retransmission to fill the gap)
+    if (acked_retransmission)
+        rtt_sample.reset();
+    // a measured RTT says which transmission was acknowledged, so it is never ambiguous
+    if (measured_rtt.has_value() && newly_acked > 0)
+        rtt_sample = measured_rtt;
+    if (rtt_sample)
+        timer_.rtt_sample(*rtt_sample);
+    if (cc_ && newly_acked > 0) {
+        if (rtt_sample)
+            cc_->on_rtt_sample(*rtt_sample);
+        if (rate_sample)
+            cc_->on_rate_sample(*rate_sample);
+        cc_->on_ack(newly_acked, bytes_in_flight());
+    }
+    update_scoreboard(sack);
+    // step 2: duplicate acks, and the end of fast recovery
+    if (newly_acked > 0) {
+        dup_acks_ = 0;
+        if (in_fast_recovery_ && abs_ackno >= recovery_point_) {
+            in_fast_recovery_ = false;
+            recovery_inflation_ = 0;
+        } else if (in_fast_recovery_) {
+            // a partial ack: the segment after the one just repaired was lost too
+            recovery_inflation_ -= min(recovery_inflation_, size_t(newly_acked));
+            if (size_t(newly_acked) >= TCPConfig::MAX_PAYLOAD_SIZE)
+                recovery_inflation_ += TCPConfig::MAX_PAYLOAD_SIZE;
+            retransmit_holes();
+        }
+    } else if (duplicate) {
+        ++dup_acks_;
+        if (in_fast_recovery_) {
+            recovery_inflation_ += TCPConfig::MAX_PAYLOAD_SIZE;
+            retransmit_holes();
+        } else if (dup_acks_ == DUP_ACK_THRESHOLD && abs_ackno > recovery_point_) {
+            in_fast_recovery_ = true;
+            recovery_point_ = next_seqno_;
+            high_rxt_ = abs_ackno;
+            if (cc_)
+                cc_->on_loss(bytes_in_flight());
+            recovery_inflation_ = DUP_ACK_THRESHOLD * TCPConfig::MAX_PAYLOAD_SIZE;
+            retransmit_holes();
+        }
+    }
+    // step 3: fill window
     if (window_size > 0 ) {
         fill_window();
     }
@@ -99,16 +216,41 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
+    time_ms_ += ms_since_last_tick;
+    if (cc_)
+        cc_->tick(ms_since_last_tick);
+    pacer_.set_rate(pacing_rate());
+    if (pacer_.limited()) {
+        // earn tokens at the pacing rate, but don't save up more than a small burst while idle
+        pacer_.tick(ms_since_last_tick);
+        if (next_seqno_ > 0 && window_size_ != 0)
+            fill_window();
+    }
     timer_.tick(ms_since_last_tick);
     // check if timer expired
     if (timer_.expired()) {
 	// retransmit the earliest oustanding segment
-	if (!segments_outstand_.empty())
-	    segments_out_.push(segments_outstand_.front());
+	if (!segments_outstand_.empty()) {
+	    retransmit_front();
+	    ++timeout_retransmissions_;
+	}
+	// a timeout ends fast recovery, and duplicate acks for what was sent before it can't start another
+	in_fast_recovery_ = false;
+	recovery_inflation_ = 0;
+	dup_acks_ = 0;
+	recovery_point_ = next_seqno_;
+	// the receiver may discard what it SACKed (RFC 2018 section 8), so start the scoreboard over
+	for (auto &outstanding : segments_outstand_)
+	    outstanding.sacked = false;
+	highest_sacked_ = 0;
 	// if window_size_ is non-zero
 	if (window_size_ != 0 || (unwrap(ackno_, isn_, next_seqno_) == 0)) {
+	    // only the first timeout of a series shrinks the window (RFC 5681 section 3.1)
+	    if (cc_ && window_size_ != 0 && consec_retrans_ == 0) {
+	        cc_->on_rto(bytes_in_flight());
+	    }
 	    ++consec_retrans_;
-	    timer_.set_timeout(2 * timer_.get_timeout());
+	    timer_.back_off();
 	}
 	timer_.reset_timer();
 	timer_.start();
@@ -117,6 +259,88 @@ void TCPSender::tick(const size_t ms_since_last_tick) {
 
 unsigned int TCPSender::consecutive_retransmissions() const { return consec_retrans_; }
 
+optional<uint64_t> TCPSender::next_timeout() const {
+    // a paced sender with data waiting sends more once the bucket has tokens again
+    const optional<unsigned int> rto = timer_.time_remaining();
+    if (pacing_rate() > 0 && next_seqno_ > 0 && window_size_ != 0 && !fin_sent_ &&
+        (stream_.buffer_size() > 0 || stream_.input_ended())) {
+        const uint64_t paced = max(uint64_t{1}, pacer_.ms_until_ready());
+        return rto.has_value() ? min<uint64_t>(paced, rto.value()) : paced;
+    }
+    // congestion control only keeps a clock, which catches up with one longer tick
+    return rto;
+}
+
+void TCPSender::retransmit(OutstandingSegment &outstanding) {
+    TCPSegment segment;
+    segment.header().seqno = wrap(outstanding.start, isn_);
+    segment.header().syn = outstanding.syn();
+    segment.header().fin = outstanding.fin();
+    segment.payload() = outstanding.payload;
+    segments_out_.push(move(segment));
+    ++outstanding.retransmissions;
+}
+
+bool TCPSender::split_outstanding(const size_t index, const uint64_t at) {
+    OutstandingSegment &head = segments_outstand_[index];
+    const uint64_t payload_start = head.start + head.syn();
+    if (at <= payload_start || at >= payload_start + head.payload.size())
+        return false;
+    OutstandingSegment tail = head;
+    const size_t head_size = at - payload_start;
+    head.end = tail.start = at;
+    head.payload.remove_suffix(head.payload.size() - head_size);
+    tail.payload.remove_prefix(head_size);
+    segments_outstand_.insert(segments_outstand_.begin() + index + 1, move(tail));
+    return true;
+}
+
+void TCPSender::split_to_wire_size(const size_t index) {
+    const OutstandingSegment &outstanding = segments_outstand_[index];
+    split_outstanding(index, outstanding.start + outstanding.syn() + mss_);
+}
+
+void TCPSender::retransmit_front() {
+    if (segments_outstand_.empty()) return;
+    // only the first piece of a super-segment is resent; the rest may well have arrived
+    split_to_wire_size(0);
+    retransmit(segments_outstand_.front());
+}
+
+void TCPSender::update_scoreboard(const vector<TCPHeader::SackBlock> &sack) {
+    const uint64_t abs_ackno = unwrap(ackno_, isn_, next_seqno_);
+    for (const auto &block : sack) {
+        const uint64_t left = unwrap(block.left, isn_, next_seqno_);
+        const uint64_t right = unwrap(block.right, isn_, next_seqno_);
+        // ignore blocks that are empty, already acknowledged, or beyond what was sent
+        if (left >= right || left < abs_ackno || right > next_seqno_) continue;
+        highest_sacked_ = max(highest_sacked_, right);
+        // (a block may cover just some pieces of a super-segment, which then splits at its edges)
+        for (size_t i = 0; i < segments_outstand_.size(); ++i) {
+            if (segments_outstand_[i].start >= right) break;
+            if (!split_outstanding(i, left))
+                split_outstanding(i, right);
+            OutstandingSegment &outstanding = segments_outstand_[i];
+            if (outstanding.start >= left && outstanding.end <= right)
+                outstanding.sacked = true;
+        }
+    }
+}
+
+void TCPSender::retransmit_holes() {
+    for (size_t i = 0; i < segments_outstand_.size(); ++i) {
+        // past the highest SACKed byte, nothing is known to be lost (but the earliest segment is, or
+        // there would be no recovery)
+        if (i > 0 && segments_outstand_[i].end > highest_sacked_) break;
+        if (segments_outstand_[i].sacked || segments_outstand_[i].start < high_rxt_) continue;
+        split_to_wire_size(i);
+        OutstandingSegment &outstanding = segments_outstand_[i];
+        retransmit(outstanding);
+        ++fast_retransmissions_;
+        high_rxt_ = outstanding.end;
+    }
+}
+
 void TCPSender::send_empty_segment() {
     TCPHeader header;
     header.seqno = wrap(next_seqno_, isn_);
@@ -124,17 +348,24 @@ void TCPSender::send_empty_segment() {
     //if (stream_.eof()) header.fin = true;
     TCPSegment segment;
     segment.header() = header;
-    segments_out_.push(segment);
+    segments_out_.push(move(segment));
 }
 
 // ***************************************************************************/
 // TCP Timer implementation below:
 // ***************************************************************************/
 
-TCPTimer::TCPTimer(const uint16_t retx_timeout)
+TCPTimer::TCPTimer(const uint16_t retx_timeout,
+                   const bool adaptive,
+                   const unsigned int min_timeout,
+                   const unsigned int max_timeout)
     : retransmission_timeout_(retx_timeout)
     , time_lapsed_(0)
-    , started_(false) {}
+    , started_(false)
+    , base_timeout_(retx_timeout)
+    , adaptive_(adaptive)
+    , min_timeout_(min_timeout)
+    , max_timeout_(max_timeout) {}
 
 void TCPTimer::tick(const size_t ms_since_last_tick) {
     if (started_) time_lapsed_ += ms_since_last_tick;
@@ -144,11 +375,39 @@ void TCPTimer::set_timeout(const unsigned int timeout) {
     retransmission_timeout_ = timeout;
 }
 
-unsigned int TCPTimer::get_timeout() {
+unsigned int TCPTimer::get_timeout() const {
     return retransmission_timeout_;
 }
 
+void TCPTimer::back_off() {
+    retransmission_timeout_ = adaptive_ ? min(2 * retransmission_timeout_, max(max_timeout_, retransmission_timeout_))
+                                        : 2 * retransmission_timeout_;
+}
+
+void TCPTimer::rtt_sample(const uint64_t rtt_ms) {
+    // RFC 6298 section 2: alpha = 1/8, beta = 1/4, K = 4, and a clock granularity of 1 ms
+    const double r = rtt_ms;
+    if (not srtt_.has_value()) {
+        srtt_ = r;
+        rttvar_ = r / 2;
+    } else {
+        rttvar_ = 0.75 * rttvar_ + 0.25 * abs(srtt_.value() - r);
+        srtt_ = 0.875 * srtt_.value() + 0.125 * r;
+    }
+    if (adaptive_) {
+        const double rto = srtt_.value() + max(1.0, 4 * rttvar_);
+        base_timeout_ = clamp(static_cast<unsigned int>(ceil(rto)), min_timeout_, max(min_timeout_, max_timeout_));
+        retransmission_timeout_ = base_timeout_;
+    }
+}
+
 bool TCPTimer::expired() {
     return started_ && (time_lapsed_ >= retransmission_timeout_);
 }
 
+optional<unsigned int> TCPTimer::time_remaining() const {
+    if (!started_)
+        return {};
+    return time_lapsed_ >= retransmission_timeout_ ? 0 : retransmission_timeout_ - time_lapsed_;
+}
+
@@ -2,30 +2,64 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
+#include "token_bucket.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <vector>
 
 //! TCPTimer helper class
 
+//! Besides the retransmission timer itself, keeps the smoothed RTT and its variation
+//! (RFC 6298) from the samples the TCPSender reports. If the timer is adaptive, the
+//! timeout the sender returns to after an acknowledgment is computed from them and
+//! kept within [min_timeout, max_timeout], as is the backed-off timeout.
 class TCPTimer {
   private:
     unsigned int retransmission_timeout_;
     unsigned int time_lapsed_;
     bool started_;
 
+    unsigned int base_timeout_;  //!< the timeout before any backoff
+    bool adaptive_;
+    unsigned int min_timeout_;
+    unsigned int max_timeout_;
+
+    std::optional<double> srtt_{};
+    double rttvar_{0};
+
   public:
-    TCPTimer(const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT);
+    TCPTimer(const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
+             const bool adaptive = false,
+             const unsigned int min_timeout = 0,
+             const unsigned int max_timeout = std::numeric_limits<unsigned int>::max());
     void start() { started_ = true; }
     void stop() { started_ = false; }
     void tick(const size_t);
     void set_timeout(const unsigned int);
-    unsigned int get_timeout();
+    unsigned int get_timeout() const;
     void reset_timer() { time_lapsed_ = 0; }
     bool expired();
+    //! Milliseconds until the timer expires (zero if it has), or nothing if it isn't running
+    std::optional<unsigned int> time_remaining() const;
+
+    //! Double the timeout after it expired (up to the maximum, if adaptive)
+    void back_off();
+    //! Undo any backoff: the timeout returns to the initial or estimated one
+    void restore_timeout() { retransmission_timeout_ = base_timeout_; }
+
+    //! A segment sent once was acknowledged `rtt_ms` after it was sent
+    void rtt_sample(const uint64_t rtt_ms);
+    //! The smoothed RTT in milliseconds, if there has been a sample
+    std::optional<double> srtt() const { return srtt_; }
 };
 
 //! \brief The "sender" part of a TCP implementation.
@@ -45,16 +79,32 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> segments_out_{};
 
-    //! outstanding segments not acknowledged yet
-    std::queue<TCPSegment> segments_outstand_{};
+    //! A segment that has been sent but not acknowledged yet: only its place in sequence space and
+    //! its payload (sharing storage with the segment sent), from which a retransmission is rebuilt
+    struct OutstandingSegment {
+        uint64_t start;                   //!< absolute seqno of its first byte (the SYN, if any)
+        uint64_t end;                     //!< absolute seqno just past it (and its FIN, if any)
+        Buffer payload;                   //!< the same storage as the payload sent
+        uint64_t sent_at_ms;              //!< when it was (first) sent, by time_ms_
+        uint64_t delivered_at_send;       //!< bytes acknowledged (absolute ackno) when it was sent
+        unsigned int retransmissions{0};  //!< if any, its ack gives no RTT sample (Karn's algorithm)
+        bool sacked{false};               //!< the receiver has said (with SACK) that it holds this segment
+
+        bool syn() const { return start == 0; }
+        bool fin() const { return end - start > payload.size() + syn(); }
+    };
 
-    //! retransmission timer for the connection
-    unsigned int initial_retransmission_timeout_;
+    //! outstanding segments not acknowledged yet (the scoreboard, in sequence order)
+    std::deque<OutstandingSegment> segments_outstand_{};
 
-    //! window size
-    uint16_t window_size_{1};
+    //! milliseconds passed to tick() so far
+    uint64_t time_ms_{0};
+
+    //! the receiver's window, in bytes (after window scaling)
+    uint32_t window_size_{1};
 
     //! outgoing stream of bytes that have not yet been sent
+    //! (chunked, so that payloads share storage with the application's writes)
     ByteStream stream_;
 
     //! the (absolute) sequence number for the next byte to be sent
@@ -69,11 +119,78 @@ class TCPSender {
     //! TCP Timer
     TCPTimer timer_;
 
+    //! congestion control, if any
+    std::unique_ptr<CongestionControl> cc_;
+
+    //! \name Fast retransmit and fast recovery (RFC 5681 section 3.2, RFC 6582)
+    //!@{
+    static constexpr unsigned int DUP_ACK_THRESHOLD = 3;
+    bool fast_retransmit_{false};  //!< whether duplicate acks are acted on at all
+    unsigned int dup_acks_{0};
+    bool in_fast_recovery_{false};
+    uint64_t recovery_point_{0};    //!< next_seqno_ when recovery (or the last timeout) began
+    size_t recovery_inflation_{0};  //!< a segment per duplicate ack: data that has left the path
+    size_t fast_retransmissions_{0};
+    size_t timeout_retransmissions_{0};
+    uint64_t highest_sacked_{0};  //!< the end of the highest SACK block received
+    uint64_t high_rxt_{0};        //!< the end of the last segment retransmitted in this recovery
+    //!@}
+
+    //! Rebuild `outstanding` and send it again
+    void retransmit(OutstandingSegment &outstanding);
+
+    //! \brief Split the outstanding segment at `index` in two, the second beginning at absolute seqno `at`
+    //! \returns false (and leaves it whole) unless `at` falls strictly inside its payload
+    bool split_outstanding(const size_t index, const uint64_t at);
+
+    //! Split the outstanding segment at `index` (a super-segment) so that it's no bigger than a wire segment
+    void split_to_wire_size(const size_t index);
+
+    //! Resend the earliest outstanding segment
+    void retransmit_front();
+
+    //! Mark the outstanding segments that `sack` says the receiver holds
+    void update_scoreboard(const std::vector<TCPHeader::SackBlock> &sack);
+
+    //! In fast recovery, resend the holes not yet resent: the earliest outstanding
+    //! segment and any segment that wasn't SACKed but something after it was
+    void retransmit_holes();
+
+    //! \name Pacing: new segments go out at a fixed rate or the congestion control's, if either is set
+    //!@{
+    double fixed_pacing_rate_{0};
+    TokenBucket pacer_{2 * TCPConfig::MAX_PAYLOAD_SIZE};
+
+    //! The rate to pace at now, in bytes per second (0 for none)
+    double pacing_rate() const;
+    //!@}
+
+    //! \name Coalescing small writes
+    //!@{
+    bool nagle_{false};   //!< hold back a small segment while anything is unacknowledged
+    bool corked_{false};  //!< hold back every small segment, until uncorked
+    //!@}
+
+    //! payload bytes in a wire segment: TCPConfig::MAX_PAYLOAD_SIZE, less room for the TCP options
+    size_t mss_{TCPConfig::MAX_PAYLOAD_SIZE};
+
+    //! send super-segments of up to TCPConfig::MAX_OFFLOAD_PAYLOAD bytes (see TCPConfig::segmentation_offload)
+    bool segmentation_offload_{false};
+    //! a super-segment cut short by the window waits for acks unless it's at least this fraction of the window
+    static constexpr size_t TSO_WIN_DIVISOR = 3;
+
+    //! Should a segment of `payload_size` bytes (all that's buffered) wait for more data?
+    bool hold_small_segment(const size_t payload_size) const;
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None);
+
+    //! Initialize a TCPSender with the sender settings in `cfg`
+    explicit TCPSender(const TCPConfig &cfg);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -85,7 +202,16 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param pure_ack whether the segment carried nothing but the acknowledgment (only those can be
+    //! duplicate acks that trigger fast retransmit)
+    //! \param sack the SACK blocks that came with the acknowledgment
+    //! \param measured_rtt an RTT the caller measured for this acknowledgment (with the timestamps
+    //! option); it is used instead of timing the acknowledged segments, even retransmitted ones
+    void ack_received(const WrappingInt32 ackno,
+                      const uint32_t window_size,
+                      const bool pure_ack = true,
+                      const std::vector<TCPHeader::SackBlock> &sack = {},
+                      const std::optional<uint64_t> measured_rtt = {});
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -93,6 +219,14 @@ class TCPSender {
     //! \brief create and send segments to fill as much of the window as possible
     void fill_window();
 
+    //! \brief Send only full-sized segments until uncorked (like TCP_CORK); uncorking lets the
+    //! next fill_window() send what's left
+    void set_corked(const bool corked) { corked_ = corked; }
+
+    //! \brief Limit the payload of a wire segment to `mss` bytes (e.g., to leave room for the TCP options
+    //! the segments will carry); segments already sent are split to fit if they have to be resent
+    void set_mss(const size_t mss) { mss_ = mss; }
+
     //! \brief Notifies the TCPSender of the passage of time
     void tick(const size_t ms_since_last_tick);
     //!@}
@@ -105,14 +239,42 @@ class TCPSender {
     //! (see TCPSegment::length_in_sequence_space())
     size_t bytes_in_flight() const;
 
+    //! \brief The most payload bytes in a wire segment (super-segments are a whole number of these)
+    size_t mss() const { return mss_; }
+
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Segments retransmitted because of duplicate acks
+    size_t fast_retransmissions() const { return fast_retransmissions_; }
+
+    //! \brief Segments retransmitted because the retransmission timer expired
+    size_t timeout_retransmissions() const { return timeout_retransmissions_; }
+
+    //! \brief Whether the sender only sends full-sized segments
+    bool corked() const { return corked_; }
+
+    //! \brief Whether the sender is recovering from a loss found by duplicate acks
+    bool in_fast_recovery() const { return in_fast_recovery_; }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
     //! (ackno and window size) before sending.
     std::queue<TCPSegment> &segments_out() { return segments_out_; }
+
+    //! \brief The smoothed round-trip time in milliseconds, once an acknowledgment has measured one
+    std::optional<double> srtt_ms() const { return timer_.srtt(); }
+
+    //! \brief The current retransmission timeout in milliseconds, including any backoff
+    unsigned int rto_ms() const { return timer_.get_timeout(); }
+
+    //! \brief Milliseconds until tick() has something to do (a retransmission, or pacing out
+    //! waiting data), or nothing if ticks can be put off until the next acknowledgment or write
+    std::optional<uint64_t> next_timeout() const;
+
+    //! \brief The congestion-control algorithm, or nullptr if there is none
+    const CongestionControl *congestion_control() const { return cc_.get(); }
     //!@}
 
     //! \name What is the next sequence number? (used for testing)
@@ -0,0 +1,28 @@
+#include "token_bucket.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+void TokenBucket::tick(const size_t ms) {
+    if (not limited()) {
+        return;
+    }
+    const double earned = rate_ * ms / 1000;
+    tokens_ = min(tokens_ + earned, max(double(burst_), earned));
+}
+
+void TokenBucket::consume(const size_t bytes) {
+    if (limited()) {
+        tokens_ -= bytes;
+    }
+}
+
+uint64_t TokenBucket::ms_until_ready() const {
+    if (ready()) {
+        return 0;
+    }
+    // the debt is paid off once tokens are strictly positive
+    return max(uint64_t{1}, uint64_t(floor(-tokens_ * 1000 / rate_)) + 1);
+}
@@ -0,0 +1,45 @@
+#ifndef SPONGE_LIBSPONGE_TOKEN_BUCKET_HH
+#define SPONGE_LIBSPONGE_TOKEN_BUCKET_HH
+
+#include <cstddef>
+#include <cstdint>
+
+//! \brief A token bucket that meters bytes out at a rate, on the clock of tick().
+
+//! Tokens (bytes) accrue at the rate and are saved up to a burst allowance. Something may be
+//! sent whenever tokens are left, even if it takes more than are left: the bucket goes into
+//! debt, which later ticks pay off. A tick also always earns its own worth, beyond the
+//! allowance, so that a coarse clock (one tick per 10 ms, say) doesn't lower the rate.
+//! The bucket starts empty.
+class TokenBucket {
+    double rate_{0};  //!< bytes per second (0 for no limit)
+    size_t burst_;    //!< most tokens saved up
+    double tokens_{0};
+
+  public:
+    //! Construct a bucket that saves up at most `burst` bytes, with no rate yet
+    explicit TokenBucket(const size_t burst) : burst_(burst) {}
+
+    //! Set the rate, in bytes per second (0 for no limit)
+    void set_rate(const double rate) { rate_ = rate; }
+
+    //! \returns the rate, in bytes per second (0 for no limit)
+    double rate() const { return rate_; }
+
+    //! \returns whether the bucket limits the rate at all
+    bool limited() const { return rate_ > 0; }
+
+    //! Earn tokens for `ms` milliseconds at the rate
+    void tick(const size_t ms);
+
+    //! \returns whether something may be sent now
+    bool ready() const { return not limited() or tokens_ > 0; }
+
+    //! Pay for `bytes` sent
+    void consume(const size_t bytes);
+
+    //! \returns milliseconds until the bucket is ready again (at least one, when it isn't ready now)
+    uint64_t ms_until_ready() const;
+};
+
+#endif  // SPONGE_LIBSPONGE_TOKEN_BUCKET_HH
@@ -1,5 +1,7 @@
 #include "buffer.hh"
 
+#include <stdexcept>
+
 using namespace std;
 
 void Buffer::remove_prefix(const size_t n) {
@@ -7,7 +9,17 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_storage and str().empty()) {
+        _storage.reset();
+    }
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _trimmed_suffix += n;
+    if (_storage and str().empty()) {
         _storage.reset();
     }
 }
@@ -18,6 +30,13 @@ void BufferList::append(const BufferList &other) {
     }
 }
 
+void BufferList::append(BufferList &&other) {
+    for (auto &buf : other._buffers) {
+        _buffers.push_back(move(buf));
+    }
+    other._buffers.clear();
+}
+
 BufferList::operator Buffer() const {
     switch (_buffers.size()) {
         case 0:
@@ -48,6 +67,15 @@ size_t BufferList::size() const {
     return ret;
 }
 
+Buffer BufferList::pop_front() {
+    if (_buffers.empty()) {
+        throw std::out_of_range("BufferList::pop_front");
+    }
+    Buffer ret = move(_buffers.front());
+    _buffers.pop_front();
+    return ret;
+}
+
 void BufferList::remove_prefix(size_t n) {
     while (n > 0) {
         if (_buffers.empty()) {
@@ -1,10 +1,12 @@
 #include "file_descriptor.hh"
 
+#include "byte_stream.hh"
 #include "util.hh"
 
 #include <algorithm>
 #include <fcntl.h>
 #include <iostream>
+#include <poll.h>
 #include <stdexcept>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -73,6 +75,33 @@ string FileDescriptor::read(const size_t limit) {
     return ret;
 }
 
+//! \param[in,out] stream is the ByteStream to be filled
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be read
+//! \returns the number of bytes read
+size_t FileDescriptor::read_into(ByteStream &stream, const size_t limit) {
+    constexpr size_t BUFFER_SIZE = 1024 * 1024;  // maximum size of a read
+    const size_t size_to_read = min({BUFFER_SIZE, limit, stream.remaining_capacity()});
+
+    if (stream.storage() == ByteStream::Storage::Chunked) {
+        // the string read becomes the stream's storage, so there is nothing to gain from readv
+        return stream.write(read(size_to_read));
+    }
+
+    auto iovecs = stream.writable_iovecs(size_to_read);
+    ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), iovecs.data(), iovecs.size()));
+    if (size_to_read > 0 && bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+    if (bytes_read > static_cast<ssize_t>(size_to_read)) {
+        throw runtime_error("readv() read more than requested");
+    }
+    stream.commit_write(bytes_read);
+
+    register_read();
+
+    return bytes_read;
+}
+
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     size_t total_bytes_written = 0;
 
@@ -108,3 +137,10 @@ void FileDescriptor::set_blocking(const bool blocking_state) {
 
     SystemCall("fcntl", fcntl(fd_num(), F_SETFL, flags));
 }
+
+//! \details Polls the descriptor without waiting; end of file or an error counts as readable, too,
+//! since a read would return at once.
+bool FileDescriptor::readable() const {
+    pollfd pfd{fd_num(), POLLIN, 0};
+    return SystemCall("poll", ::poll(&pfd, 1, 0)) > 0 and (pfd.revents & (POLLIN | POLLHUP | POLLERR));
+}
@@ -8,6 +8,8 @@
 #include <limits>
 #include <memory>
 
+class ByteStream;
+
 //! A reference-counted handle to a file descriptor
 class FileDescriptor {
     //! \brief A handle on a kernel file descriptor.
@@ -61,6 +63,10 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! Read up to `limit` bytes straight into the free space of `stream`
+    //! \returns the number of bytes read
+    size_t read_into(ByteStream &stream, const size_t limit = std::numeric_limits<size_t>::max());
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
 
@@ -79,6 +85,9 @@ class FileDescriptor {
     //! Set blocking(true) or non-blocking(false)
     void set_blocking(const bool blocking_state);
 
+    //! Is there something to read right now (so that a read wouldn't block)?
+    bool readable() const;
+
     //! \name FDWrapper accessors
     //!@{
 
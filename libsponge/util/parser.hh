@@ -35,7 +35,7 @@ class NetParser {
     T _parse_int();
 
   public:
-    NetParser(Buffer buffer) : _buffer(buffer) {}
+    NetParser(Buffer buffer) : _buffer(std::move(buffer)) {}
 
     Buffer buffer() const { return _buffer; }
 
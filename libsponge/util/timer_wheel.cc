@@ -0,0 +1,188 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+TimerWheel::TimerWheel(const uint64_t now_ms) : _now(now_ms) { _slots.fill(NONE); }
+
+uint32_t TimerWheel::allocate() {
+    if (_free == NONE) {
+        _nodes.emplace_back();
+        return _nodes.size() - 1;
+    }
+    const uint32_t index = _free;
+    _free = _nodes[index].next;
+    return index;
+}
+
+void TimerWheel::release(const uint32_t index) {
+    Node &node = _nodes[index];
+    node.callback = nullptr;
+    node.slot = NONE;
+    node.generation++;
+    node.prev = NONE;
+    node.next = _free;
+    _free = index;
+}
+
+//! A timer goes in level L if its deadline and the next millisecond differ in group L of SLOT_BITS bits
+//! but in none above it, in the slot for the deadline's group L. The wheel then reaches that slot exactly
+//! when the deadline's group L comes up, and cascading moves the timer to a lower level.
+void TimerWheel::link(const uint32_t index) {
+    Node &node = _nodes[index];
+    const uint64_t base = _now + 1;
+    const uint64_t deadline = max(node.deadline, base);
+
+    uint32_t slot = NONE;
+    for (size_t level = 0; level + 1 < LEVELS; ++level) {
+        if ((deadline >> (SLOT_BITS * (level + 1))) == (base >> (SLOT_BITS * (level + 1)))) {
+            slot = level * SLOTS + ((deadline >> (SLOT_BITS * level)) & (SLOTS - 1));
+            break;
+        }
+    }
+    if (slot == NONE) {
+        // the top level has no level above it, so it takes anything that comes up before its slots wrap;
+        // a timer beyond that is parked in the slot that comes up last, and placed again from there
+        constexpr size_t top_shift = SLOT_BITS * (LEVELS - 1);
+        const uint64_t top_index = (deadline >> top_shift) - (base >> top_shift) < SLOTS ? deadline >> top_shift
+                                                                                        : (base >> top_shift) - 1;
+        slot = (LEVELS - 1) * SLOTS + (top_index & (SLOTS - 1));
+    }
+
+    node.slot = slot;
+    node.prev = NONE;
+    node.next = _slots[slot];
+    if (node.next != NONE) {
+        _nodes[node.next].prev = index;
+    }
+    _slots[slot] = index;
+}
+
+void TimerWheel::unlink(const uint32_t index) {
+    Node &node = _nodes[index];
+    if (node.prev == NONE) {
+        _slots[node.slot] = node.next;
+    } else {
+        _nodes[node.prev].next = node.next;
+    }
+    if (node.next != NONE) {
+        _nodes[node.next].prev = node.prev;
+    }
+    node.prev = node.next = NONE;
+}
+
+uint32_t TimerWheel::find(const TimerId id) const {
+    const uint32_t index = id & UINT32_MAX;
+    const uint32_t generation = id >> 32;
+    if (index >= _nodes.size() or _nodes[index].generation != generation or _nodes[index].slot == NONE) {
+        return NONE;
+    }
+    return index;
+}
+
+//! \details Called with the clock just before the first millisecond of the slot's span,
+//! so every timer in it lands in a lower level (or is parked again, if still beyond the wheel's span).
+void TimerWheel::cascade(const size_t level) {
+    const size_t slot = level * SLOTS + (((_now + 1) >> (SLOT_BITS * level)) & (SLOTS - 1));
+    uint32_t index = _slots[slot];
+    _slots[slot] = NONE;
+    while (index != NONE) {
+        const uint32_t next = _nodes[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+//! \details A level's slots come up one after another, each at the first millisecond of its span; the slots
+//! behind the current one are empty, except for the top level's parking slot, which comes up last.
+uint64_t TimerWheel::next_busy(const uint64_t limit) const {
+    uint64_t busy = limit;
+    for (size_t level = 0; level < LEVELS; ++level) {
+        const size_t shift = SLOT_BITS * level;
+        const uint64_t first = ((_now + (uint64_t{1} << shift)) >> shift) << shift;
+        if (first >= busy) {
+            break;  // (and so would every level above)
+        }
+        for (size_t i = 0; i < SLOTS; ++i) {
+            const uint64_t start = first + (uint64_t{i} << shift);
+            if (start >= busy) {
+                break;
+            }
+            if (_slots[level * SLOTS + ((start >> shift) & (SLOTS - 1))] != NONE) {
+                busy = start;
+                break;
+            }
+        }
+    }
+    return busy;
+}
+
+TimerWheel::TimerId TimerWheel::schedule(const uint64_t deadline_ms, CallbackT callback) {
+    const uint32_t index = allocate();
+    Node &node = _nodes[index];
+    node.deadline = deadline_ms;
+    node.callback = move(callback);
+    link(index);
+    _scheduled++;
+    return (TimerId{node.generation} << 32) | index;
+}
+
+bool TimerWheel::reschedule(const TimerId id, const uint64_t deadline_ms) {
+    const uint32_t index = find(id);
+    if (index == NONE) {
+        return false;
+    }
+    unlink(index);
+    _nodes[index].deadline = deadline_ms;
+    link(index);
+    return true;
+}
+
+void TimerWheel::cancel(const TimerId id) {
+    const uint32_t index = find(id);
+    if (index == NONE) {
+        return;
+    }
+    unlink(index);
+    release(index);
+    _scheduled--;
+}
+
+//! \details Callbacks may schedule and cancel timers (including their own, which is already gone).
+//! A timer scheduled for a time that has already come fires at the next millisecond processed.
+void TimerWheel::advance_to(const uint64_t now_ms) {
+    while (_now < now_ms) {
+        if (_scheduled == 0) {
+            _now = now_ms;
+            return;
+        }
+
+        // the milliseconds in between have nothing to fire or cascade
+        const uint64_t next = next_busy(now_ms);
+        _now = next - 1;
+        for (size_t level = LEVELS - 1; level > 0; --level) {
+            if ((next & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+
+        // the slot's timers go on a list of their own first, since a callback may schedule into the slot again
+        _now = next;
+        const size_t slot = next & (SLOTS - 1);
+        _slots[DUE] = _slots[slot];
+        _slots[slot] = NONE;
+        for (uint32_t index = _slots[DUE]; index != NONE; index = _nodes[index].next) {
+            _nodes[index].slot = DUE;
+        }
+        while (_slots[DUE] != NONE) {
+            const uint32_t index = _slots[DUE];
+            unlink(index);
+            CallbackT callback = move(_nodes[index].callback);
+            release(index);
+            _scheduled--;
+            callback();
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+//! \brief A hierarchical timer wheel: one-shot timers with millisecond deadlines.
+
+//! Advancing the wheel by a millisecond only looks at the timers due in that
+//! millisecond, so many mostly-idle owners (e.g., connections) can share one wheel
+//! instead of each being polled on every tick. Each level has SLOTS slots, each
+//! SLOTS times wider than the last; a timer waits in the level that its distance
+//! to the deadline calls for, and moves down a level (is "cascaded") when the
+//! wheel reaches its slot. Scheduling and cancelling are O(1), and advancing skips
+//! straight to the next slot that has timers, however far away it is.
+class TimerWheel {
+  public:
+    //! Identifies a scheduled timer (stale identifiers are recognized and ignored)
+    using TimerId = uint64_t;
+    using CallbackT = std::function<void(void)>;
+
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+
+  private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint32_t DUE = LEVELS * SLOTS;  //!< the list of timers being fired
+
+    //! A timer, in the list of its slot (or in the free list)
+    struct Node {
+        uint64_t deadline{0};
+        CallbackT callback{};
+        uint32_t prev{NONE};
+        uint32_t next{NONE};
+        uint32_t slot{NONE};     //!< level * SLOTS + index, DUE, or NONE if not scheduled
+        uint32_t generation{0};  //!< bumped when the node is freed, to invalidate old TimerIds
+    };
+
+    std::vector<Node> _nodes{};
+    uint32_t _free{NONE};                           //!< head of the free list (linked by Node::next)
+    std::array<uint32_t, DUE + 1> _slots{};         //!< heads of the slots' lists, and of DUE
+    uint64_t _now;                                  //!< the last millisecond processed
+    size_t _scheduled{0};
+
+    uint32_t allocate();
+    void release(const uint32_t index);
+    //! Put a node in the slot its deadline calls for, relative to the next millisecond to be processed
+    void link(const uint32_t index);
+    void unlink(const uint32_t index);
+
+    //! \returns the node that `id` names, or NONE if the timer has fired or been cancelled
+    uint32_t find(const TimerId id) const;
+
+    //! Move the timers of a slot to the slots their deadlines now call for
+    void cascade(const size_t level);
+
+    //! \returns the first millisecond after the current one at which a slot with timers comes up
+    //! (to fire or cascade them), or `limit` if that's earlier
+    uint64_t next_busy(const uint64_t limit) const;
+
+  public:
+    //! Construct a wheel whose clock reads `now_ms`
+    explicit TimerWheel(const uint64_t now_ms = 0);
+
+    //! \brief Call `callback` once the clock reaches `deadline_ms` (or at the next advance, if it already has)
+    TimerId schedule(const uint64_t deadline_ms, CallbackT callback);
+
+    //! Move a scheduled timer to a new deadline
+    //! \returns false if the timer had already fired or been cancelled
+    bool reschedule(const TimerId id, const uint64_t deadline_ms);
+
+    //! Cancel a timer (does nothing if it already fired or was cancelled)
+    void cancel(const TimerId id);
+
+    //! Advance the clock to `now_ms`, calling the callbacks of the timers that come due, in deadline order
+    void advance_to(const uint64_t now_ms);
+
+    //! Advance the clock by `ms`
+    void tick(const uint64_t ms) { advance_to(_now + ms); }
+
+    //! \returns the current time of the wheel's clock
+    uint64_t now() const { return _now; }
+
+    //! \returns the number of timers that are scheduled
+    size_t size() const { return _scheduled; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
@@ -0,0 +1,82 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        const auto chunked = ByteStream::Storage::Chunked;
+
+        {
+            ByteStreamTestHarness test{"chunked-overwrite-pop-overwrite", 2, chunked};
+
+            test.execute(Write{"cat"}.with_bytes_written(2));
+            test.execute(Pop{1});
+            test.execute(Write{"tac"}.with_bytes_written(1));
+
+            test.execute(InputEnded{false});
+            test.execute(BufferEmpty{false});
+            test.execute(Eof{false});
+            test.execute(BytesRead{1});
+            test.execute(BytesWritten{3});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{2});
+            test.execute(Peek{"at"});
+            test.execute(PeekViews{"at", 2});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked-many-chunks", 15, chunked};
+
+            test.execute(Write{"abc"}.with_bytes_written(3));
+            test.execute(Write{""}.with_bytes_written(0));
+            test.execute(Write{"defg"}.with_bytes_written(4));
+            test.execute(Write{"hi"}.with_bytes_written(2));
+            test.execute(Peek{"abcdefghi"});
+            test.execute(PeekViews{"abcde", 2});
+            test.execute(Pop{4});
+            test.execute(PeekViews{"efghi", 2});
+            test.execute(EndInput{});
+            test.execute(Pop{5});
+            test.execute(BufferEmpty{true});
+            test.execute(Eof{true});
+            test.execute(BytesRead{9});
+        }
+
+        {
+            // read_buffer shares the written string when the bytes lie within one write
+            ByteStream stream{10, chunked};
+            test_should_be(stream.write(string{"abcdefgh"}), size_t{8});
+            test_should_be(stream.write(string{"ijklm"}), size_t{2});
+
+            const Buffer first = stream.read_buffer(3);
+            const Buffer second = stream.read_buffer(5);
+            test_should_be(first.copy(), string{"abc"});
+            test_should_be(second.copy(), string{"defgh"});
+            test_should_be(first.str().data() + 3 == second.str().data(), true);
+
+            const Buffer third = stream.read_buffer(10);
+            test_should_be(third.copy(), string{"ij"});
+            test_should_be(stream.buffer_empty(), true);
+            test_should_be(stream.bytes_read(), size_t{10});
+        }
+
+        {
+            // reads that span writes are coalesced into one Buffer
+            ByteStream stream{10, chunked};
+            stream.write(string{"ab"});
+            stream.write(string{"cd"});
+            test_should_be(stream.read_buffer(3).copy(), string{"abc"});
+            test_should_be(stream.read_buffer(3).copy(), string{"d"});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
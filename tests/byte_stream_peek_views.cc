@@ -0,0 +1,55 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"peek-views-contiguous", 4};
+
+            test.execute(PeekViews{"", 0});  // (an empty ring has nothing to view)
+            test.execute(Write{"abc"}.with_bytes_written(3));
+            test.execute(PeekViews{"ab", 1});
+            test.execute(PeekViews{"abc", 1});
+            test.execute(Pop{1});
+            test.execute(PeekViews{"bc", 1});
+            test.execute(BufferSize{2});
+        }
+
+        {
+            ByteStreamTestHarness test{"peek-views-wrapped", 4};
+
+            test.execute(Write{"abc"}.with_bytes_written(3));
+            test.execute(Pop{2});
+            test.execute(Write{"def"}.with_bytes_written(3));
+            test.execute(PeekViews{"cd", 1});
+            test.execute(PeekViews{"cde", 2});
+            test.execute(PeekViews{"cdef", 2});
+            test.execute(Peek{"cdef"});
+            test.execute(Pop{2});
+            test.execute(PeekViews{"ef", 1});
+            test.execute(BytesRead{4});
+            test.execute(RemainingCapacity{2});
+        }
+
+        {
+            ByteStreamTestHarness test{"peek-views-odd-capacity", 3};
+
+            test.execute(Write{"cat"}.with_bytes_written(3));
+            test.execute(Pop{2});
+            test.execute(Write{"tac"}.with_bytes_written(2));
+            test.execute(RemainingCapacity{0});
+            test.execute(PeekViews{"tta", 2});
+            test.execute(Peek{"tta"});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
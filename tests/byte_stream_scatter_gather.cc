@@ -0,0 +1,76 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        for (const auto storage : {ByteStream::Storage::Ring, ByteStream::Storage::Chunked}) {
+            // write a discontiguous string
+            ByteStream stream{6, storage};
+            BufferViewList views{"ab"};
+            views.append("cde");
+            views.append("fgh");
+            test_should_be(stream.write(views), size_t{6});
+            test_should_be(stream.peek_output(6), string{"abcdef"});
+            test_should_be(stream.bytes_written(), size_t{6});
+
+            // read into caller-provided storage
+            char dest[4] = {};
+            test_should_be(stream.read_into(dest, 4), size_t{4});
+            test_should_be(string(dest, 4), string{"abcd"});
+
+            string str;
+            test_should_be(stream.read_into(str, 10), size_t{2});
+            test_should_be(str, string{"ef"});
+            test_should_be(stream.buffer_empty(), true);
+            test_should_be(stream.bytes_read(), size_t{6});
+        }
+
+        {
+            // fill the ring's free space directly, across the wrap-around point
+            ByteStream stream{4};
+            stream.write("abc");
+            stream.pop_output(3);
+
+            auto iovecs = stream.writable_iovecs(10);
+            test_should_be(iovecs.size(), size_t{2});
+            test_should_be(iovecs[0].iov_len + iovecs[1].iov_len, size_t{4});
+            memcpy(iovecs[0].iov_base, "w", 1);
+            memcpy(iovecs[1].iov_base, "xy", 2);
+            stream.commit_write(3);
+
+            test_should_be(stream.peek_output(4), string{"wxy"});
+            test_should_be(stream.remaining_capacity(), size_t{1});
+            test_should_be(stream.bytes_written(), size_t{6});
+        }
+
+        {
+            // a ring with no storage yet (or no room) exposes nothing, and writing or reading nothing is a no-op
+            ByteStream stream{4};
+            test_should_be(stream.write(""), size_t{0});
+            test_should_be(stream.writable_iovecs(0).empty(), true);
+            test_should_be(stream.peek_views(4).as_iovecs().empty(), true);
+            char buf[4];
+            test_should_be(stream.read_into(buf, 4), size_t{0});
+            stream.write("abcd");
+            test_should_be(stream.writable_iovecs(4).empty(), true);
+        }
+
+        {
+            // a chunked stream has no ring to expose
+            ByteStream stream{4, ByteStream::Storage::Chunked};
+            test_should_be(stream.writable_iovecs(4).empty(), true);
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -45,11 +45,13 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name,
+                                             const size_t capacity,
+                                             const ByteStream::Storage storage)
+    : _test_name(test_name), _byte_stream(capacity, storage) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << (storage == ByteStream::Storage::Chunked ? ", chunked" : "") << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
@@ -182,3 +184,23 @@ void Peek::execute(ByteStream &bs) const {
                                              output + "\"");
     }
 }
+
+// PeekViews
+PeekViews::PeekViews(const std::string &output, const size_t num_views) : _output(output), _num_views(num_views) {}
+std::string PeekViews::description() const {
+    return "\"" + _output + "\" at the front of the stream, in " + to_string(_num_views) + " view(s)";
+}
+void PeekViews::execute(ByteStream &bs) const {
+    const auto iovecs = bs.peek_views(_output.size()).as_iovecs();
+    std::string output;
+    for (const auto &iov : iovecs) {
+        output.append(static_cast<const char *>(iov.iov_base), iov.iov_len);
+    }
+    if (output != _output) {
+        throw ByteStreamExpectationViolation("Expected \"" + _output + "\" at the front of the stream, but found \"" +
+                                             output + "\"");
+    }
+    if (iovecs.size() != _num_views) {
+        throw ByteStreamExpectationViolation::property("number of views", _num_views, iovecs.size());
+    }
+}
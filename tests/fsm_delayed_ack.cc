@@ -0,0 +1,110 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const string FULL(TCPConfig::MAX_PAYLOAD_SIZE, 'x');
+
+//! A data segment from the peer, acknowledging our SYN
+static SendSegment data_segment(const WrappingInt32 seqno, const WrappingInt32 ackno, const string &data) {
+    return SendSegment{}.with_ack(true).with_seqno(seqno).with_ackno(ackno).with_win(1000).with_data(string(data));
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.delayed_ack = true;
+        cfg.ack_delay = 40;
+
+        // test 1: every second full-sized segment is acknowledged at once
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_1 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            for (uint32_t i = 0; i < 3; ++i) {
+                test_1.execute(data_segment(rx_isn + 1 + 2 * i * FULL.size(), tx_isn + 1, FULL));
+                test_1.execute(ExpectNoSegment{}, "test 1 failed: first full-sized segment acknowledged at once");
+                test_1.execute(data_segment(rx_isn + 1 + (2 * i + 1) * FULL.size(), tx_isn + 1, FULL));
+                test_1.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1 + 2 * (i + 1) * FULL.size()),
+                               "test 1 failed: second full-sized segment not acknowledged");
+            }
+            test_1.execute(Tick(cfg.ack_delay));
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: acknowledged twice");
+        }
+
+        // test 2: a lone small segment is acknowledged after the delay
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_2 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            test_2.execute(data_segment(rx_isn + 1, tx_isn + 1, "hello"));
+            test_2.execute(Tick(cfg.ack_delay - 1));
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: acknowledged before the delay");
+            test_2.execute(Tick(1));
+            test_2.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 6).with_payload_size(0),
+                           "test 2 failed: not acknowledged after the delay");
+            test_2.execute(Tick(cfg.ack_delay));
+            test_2.execute(ExpectNoSegment{});
+        }
+
+        // test 3: out-of-order data is acknowledged at once, and so is the segment that fills the gap
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_3 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            test_3.execute(data_segment(rx_isn + 1, tx_isn + 1, "abc"));
+            test_3.execute(ExpectNoSegment{});
+            test_3.execute(data_segment(rx_isn + 7, tx_isn + 1, "ghi"));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 4),
+                           "test 3 failed: out-of-order segment not acknowledged at once");
+            test_3.execute(data_segment(rx_isn + 4, tx_isn + 1, "def"));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 10),
+                           "test 3 failed: segment filling the gap not acknowledged at once");
+            test_3.execute(ExpectData{}.with_data("abcdefghi"));
+
+            // a duplicate is acknowledged at once too
+            test_3.execute(data_segment(rx_isn + 1, tx_isn + 1, "abc"));
+            test_3.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 10),
+                           "test 3 failed: duplicate segment not acknowledged at once");
+        }
+
+        // test 4: our data carries the pending acknowledgment, and a FIN is acknowledged at once
+        {
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_4 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            test_4.execute(data_segment(rx_isn + 1, tx_isn + 1, "ping"));
+            test_4.execute(ExpectNoSegment{});
+            test_4.execute(Write{"pong"});
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 5).with_data("pong"),
+                           "test 4 failed: data didn't carry the acknowledgment");
+            test_4.execute(Tick(cfg.ack_delay));
+            test_4.execute(ExpectNoSegment{}, "test 4 failed: acknowledgment sent again after the delay");
+
+            test_4.send_fin(rx_isn + 5, tx_isn + 5);
+            test_4.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 6),
+                           "test 4 failed: FIN not acknowledged at once");
+        }
+
+        // test 5: without delayed acks, every segment is acknowledged at once
+        {
+            cfg.delayed_ack = false;
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_5 = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+            test_5.execute(data_segment(rx_isn + 1, tx_isn + 1, "hello"));
+            test_5.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 6));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
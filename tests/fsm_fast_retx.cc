@@ -0,0 +1,109 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr unsigned NREPS = 16;
+static constexpr size_t NSEGS = 10;
+
+//! Send a window of NSEGS full segments through a looped-back FSM, losing the segments in `lost`
+//! once each. Every step takes a millisecond, so recovery can't have waited for the timer.
+//! With SACK, every hole must have been resent before the first retransmission comes back.
+static void lose_and_recover(const TCPConfig &cfg, const set<size_t> &lost, const size_t fast_retransmissions) {
+    auto rd = get_random_generator();
+    const WrappingInt32 rx_offset(rd());
+    TCPTestHarness test = TCPTestHarness::in_syn_sent(cfg, rx_offset - 1);
+    test.execute(SendSegment{}
+                     .with_syn(true)
+                     .with_ack(true)
+                     .with_seqno(rx_offset - 1)
+                     .with_ackno(rx_offset)
+                     .with_win(65000)
+                     .with_sack_permitted(cfg.sack));
+    test.execute(ExpectOneSegment{}.with_no_flags().with_ack(true).with_ackno(rx_offset).with_payload_size(0));
+
+    string d(NSEGS * TCPConfig::MAX_PAYLOAD_SIZE, 0);
+    generate(d.begin(), d.end(), [&] { return rd(); });
+    test.execute(Write{d});
+    test.execute(Tick(1));
+
+    vector<TCPSegment> data_segments;
+    for (size_t i = 0; i < NSEGS; ++i) {
+        data_segments.push_back(test.expect_seg(ExpectSegment{}.with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE)));
+    }
+    test.execute(ExpectNoSegment{});
+
+    // deliver all but the lost segments; each one is acknowledged
+    for (size_t i = 0; i < NSEGS; ++i) {
+        if (not lost.count(i)) {
+            test.execute(SendSegment{move(data_segments[i])});
+            test.execute(Tick(1));
+        }
+    }
+
+    // loop everything back (acks, and the retransmissions they trigger) until the FSM goes quiet
+    size_t steps = 0;
+    bool retransmission_returned = false;
+    while (test.can_read()) {
+        auto seg = test.expect_seg(ExpectSegment{});
+        if (cfg.sack and not retransmission_returned and seg.payload().size() > 0) {
+            retransmission_returned = true;
+            test.execute(ExpectRetransmissions{fast_retransmissions, 0}, "SACK did not resend every hole at once");
+        }
+        test.execute(SendSegment{move(seg)});
+        test.execute(Tick(1));
+        if (++steps > 10 * NSEGS) {
+            throw runtime_error("segments are still being exchanged after " + to_string(steps) + " steps");
+        }
+    }
+
+    test.execute(ExpectBytesInFlight{0}, "the lost segments were not recovered");
+    test.execute(ExpectData{}.with_data(d), "got back the wrong data");
+    test.execute(ExpectRetransmissions{fast_retransmissions, 0});
+}
+
+int main() {
+    try {
+        TCPConfig cfg{};
+        cfg.recv_capacity = 65000;
+        cfg.fast_retransmit = true;
+
+        for (const auto algorithm : {CongestionControl::Algorithm::None, CongestionControl::Algorithm::NewReno}) {
+            cfg.congestion_control = algorithm;
+            for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+                // one loss: three duplicate acks retransmit it
+                lose_and_recover(cfg, {2}, 1);
+
+                // two losses in a window: the partial ack after the first one retransmits the second
+                lose_and_recover(cfg, {2, 5}, 2);
+            }
+        }
+
+        // with SACK, both holes are known (and resent) on the third duplicate ack; looped back, the FSM's own
+        // receiver is holding what's around the holes, so its SACK blocks leave each resent segment too little
+        // room, and it goes out in two
+        cfg.sack = true;
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            lose_and_recover(cfg, {2, 5}, 2 * 2);
+            lose_and_recover(cfg, {1, 3, 5, 7}, 2 * 4);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr uint16_t WIN = 10000;
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! An established connection, with a window from the peer
+static TCPTestHarness established(const TCPConfig &cfg, const WrappingInt32 tx_isn, const WrappingInt32 rx_isn) {
+    TCPTestHarness test = TCPTestHarness::in_established(cfg, tx_isn, rx_isn);
+    test.send_ack(rx_isn + 1, tx_isn + 1, WIN);
+    test.execute(ExpectNoSegment{});
+    return test;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: with Nagle, small writes wait while anything is unacknowledged, then go out together
+        {
+            TCPConfig cfg{};
+            cfg.nagle = true;
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_1 = established(cfg, tx_isn, rx_isn);
+
+            test_1.execute(Write{"a"});
+            test_1.execute(ExpectOneSegment{}.with_data("a"), "test 1 failed: first write held back");
+            test_1.execute(Write{"b"});
+            test_1.execute(Write{"c"});
+            test_1.execute(ExpectNoSegment{}, "test 1 failed: small write sent while data is unacknowledged");
+            test_1.send_ack(rx_isn + 1, tx_isn + 2, WIN);
+            test_1.execute(ExpectOneSegment{}.with_data("bc"), "test 1 failed: held-back writes not coalesced");
+
+            // full-sized segments go out at once, and only the small remainder waits
+            test_1.execute(Write{string(MSS + 10, 'd')});
+            test_1.execute(ExpectOneSegment{}.with_payload_size(MSS), "test 1 failed: full-sized segment held back");
+            test_1.execute(ExpectNoSegment{});
+            test_1.send_ack(rx_isn + 1, tx_isn + 4 + MSS, WIN);
+            test_1.execute(ExpectOneSegment{}.with_payload_size(10));
+
+            // the last small segment goes out with the FIN
+            test_1.execute(Write{"e"});
+            test_1.execute(ExpectNoSegment{});
+            test_1.execute(Close{});
+            test_1.execute(ExpectOneSegment{}.with_fin(true).with_data("e"), "test 1 failed: FIN held back");
+        }
+
+        // test 2: corked, writes only go out in full-sized segments, and uncorking sends the rest
+        {
+            TCPConfig cfg{};
+            const WrappingInt32 tx_isn(rd()), rx_isn(rd());
+            TCPTestHarness test_2 = established(cfg, tx_isn, rx_isn);
+
+            test_2.execute(Cork{});
+            test_2.execute(Write{"hello, "});
+            test_2.execute(Write{"world"});
+            test_2.execute(ExpectNoSegment{}, "test 2 failed: corked write sent");
+            test_2.execute(Write{string(MSS, 'x')});
+            test_2.execute(ExpectOneSegment{}.with_payload_size(MSS), "test 2 failed: full-sized segment held back");
+            test_2.execute(ExpectNoSegment{});
+            test_2.execute(Uncork{});
+            test_2.execute(ExpectOneSegment{}.with_payload_size(12), "test 2 failed: uncorking didn't send the rest");
+
+            // uncorked, without Nagle, every write goes out at once
+            test_2.execute(Write{"a"});
+            test_2.execute(ExpectOneSegment{}.with_data("a"));
+            test_2.execute(Write{"b"});
+            test_2.execute(ExpectOneSegment{}.with_data("b"));
+        }
+
+        // test 3: corking before the connection exists holds back nothing but data
+        {
+            TCPConfig cfg{};
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Listen{});
+            test_3.execute(Cork{});
+            test_3.execute(Uncork{});
+            test_3.execute(ExpectNoSegment{}, "test 3 failed: uncorking a listening connection sent something");
+            test_3.send_syn(rx_isn);
+            test_3.execute(ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
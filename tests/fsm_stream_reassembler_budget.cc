@@ -0,0 +1,90 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "reassembly_budget.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <optional>
+
+using namespace std;
+
+static void expect_held(const ReassemblyBudget &budget, const size_t held, const size_t peak) {
+    if (budget.held() != held or budget.peak() != peak) {
+        throw runtime_error("The budget was expected to hold `" + to_string(held) + "` bytes (peak `" +
+                            to_string(peak) + "`), but it held `" + to_string(budget.held()) + "` (peak `" +
+                            to_string(budget.peak()) + "`)");
+    }
+}
+
+int main() {
+    try {
+        {
+            // a per-stream limit on out-of-order bytes, with no shared budget
+            ReassemblerTestHarness test{100, nullptr, 6};
+
+            test.execute(SubmitSegment{"cdef", 2});
+            test.execute(UnassembledBytes(4));
+
+            // only two more bytes may be held: the newest ones are dropped
+            test.execute(SubmitSegment{"ijkl", 8});
+            test.execute(UnassembledBytes(6));
+            test.execute(DroppedBytes(2));
+
+            // in-order bytes are never limited
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAssembled(6));
+            test.execute(UnassembledBytes(2));
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(BytesAssembled(10));
+            test.execute(UnassembledBytes(0));
+            test.execute(SubmitSegment{"klmn", 10});
+            test.execute(BytesAssembled(14));
+            test.execute(BytesAvailable("abcdefghijklmn"));
+            test.execute(PeakUnassembledBytes(6));
+            test.execute(DroppedBytes(2));
+        }
+
+        {
+            // two streams sharing a budget
+            ReassemblyBudget budget{6};
+            ReassemblerTestHarness first{100, &budget, 100};
+            {
+                ReassemblerTestHarness second{100, &budget, 100};
+
+                first.execute(SubmitSegment{"efgh", 4});
+                expect_held(budget, 4, 4);
+
+                second.execute(SubmitSegment{"efgh", 4});
+                second.execute(UnassembledBytes(2));
+                second.execute(DroppedBytes(2));
+                expect_held(budget, 6, 6);
+
+                // the budget is exhausted, so nothing new is held
+                first.execute(SubmitSegment{"z", 20});
+                first.execute(UnassembledBytes(4));
+                first.execute(DroppedBytes(1));
+
+                // assembling the held bytes gives them back to the budget
+                first.execute(SubmitSegment{"abcd", 0});
+                first.execute(BytesAvailable("abcdefgh"));
+                expect_held(budget, 2, 6);
+
+                first.execute(SubmitSegment{"jklm", 9});
+                first.execute(UnassembledBytes(4));
+                expect_held(budget, 6, 6);
+            }
+
+            // destroying a reassembler gives back what it held
+            expect_held(budget, 4, 6);
+            budget.reset_peak();
+            expect_held(budget, 4, 4);
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
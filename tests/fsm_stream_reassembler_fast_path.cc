@@ -0,0 +1,72 @@
+#include "byte_stream.hh"
+#include "fsm_stream_reassembler_harness.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"abcd", 0});
+            test.execute(SubmitSegment{"efgh", 4});
+            test.execute(SubmitSegment{"ijkl", 8}.with_eof(true));
+            test.execute(PathCounts{3, 0});
+            test.execute(BytesAssembled(12));
+            test.execute(BytesAvailable("abcdefghijkl"));
+            test.execute(AtEof{});
+        }
+
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(SubmitSegment{"abcd", 0});
+            test.execute(PathCounts{1, 0});
+
+            // out of order: held until the gap is filled
+            test.execute(SubmitSegment{"ijkl", 8});
+            test.execute(PathCounts{1, 1});
+            test.execute(UnassembledBytes(4));
+
+            // in order, but with bytes pending: must take the slow path to flush them
+            test.execute(SubmitSegment{"efgh", 4});
+            test.execute(PathCounts{1, 2});
+            test.execute(UnassembledBytes(0));
+            test.execute(BytesAssembled(12));
+
+            // nothing pending again
+            test.execute(SubmitSegment{"mnop", 12});
+            test.execute(PathCounts{2, 2});
+            test.execute(BytesAvailable("abcdefghijklmnop"));
+
+            // duplicates never take the fast path
+            test.execute(SubmitSegment{"mnop", 12});
+            test.execute(PathCounts{2, 3});
+            test.execute(BytesAssembled(16));
+        }
+
+        {
+            ReassemblerTestHarness test{8};
+
+            // an in-order substring that overruns the window is truncated on the fast path
+            test.execute(SubmitSegment{"abcdefghij", 0});
+            test.execute(PathCounts{1, 0});
+            test.execute(BytesAssembled(8));
+            test.execute(BytesAvailable("abcdefgh"));
+
+            test.execute(SubmitSegment{"ij", 8});
+            test.execute(PathCounts{2, 0});
+            test.execute(BytesAvailable("ij"));
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -10,6 +10,13 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
+
+//! The fsm_stream_reassembler_* tests are also built with
+//! REASSEMBLER_BACKEND=Bitmap to run them against that backend.
+#ifndef REASSEMBLER_BACKEND
+#define REASSEMBLER_BACKEND IntervalMap
+#endif
 
 class ReassemblerExpectationViolation : public std::runtime_error {
   public:
@@ -103,6 +110,72 @@ struct UnassembledBytes : public ReassemblerExpectation {
     }
 };
 
+struct PeakUnassembledBytes : public ReassemblerExpectation {
+    size_t _bytes;
+
+    PeakUnassembledBytes(size_t bytes) : _bytes(bytes) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "peak bytes not assembled = " << _bytes;
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.peak_unassembled_bytes() != _bytes) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to have held at most `" << _bytes
+               << "` bytes not assembled, but it held `" << reassembler.peak_unassembled_bytes() << "`";
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct DroppedBytes : public ReassemblerExpectation {
+    size_t _bytes;
+
+    DroppedBytes(size_t bytes) : _bytes(bytes) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "bytes dropped for lack of budget = " << _bytes;
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.dropped_bytes() != _bytes) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to have dropped `" << _bytes << "` bytes, but it dropped `"
+               << reassembler.dropped_bytes() << "`";
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct UnassembledRanges : public ReassemblerExpectation {
+    std::vector<std::pair<uint64_t, uint64_t>> _ranges;
+
+    UnassembledRanges(std::vector<std::pair<uint64_t, uint64_t>> ranges) : _ranges(std::move(ranges)) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "unassembled ranges =";
+        for (const auto &[begin, end] : _ranges) {
+            ss << " [" << begin << ", " << end << ")";
+        }
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        const auto actual = reassembler.unassembled_ranges();
+        if (actual != _ranges) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to hold " << _ranges.size() << " out-of-order ranges, but it held";
+            for (const auto &[begin, end] : actual) {
+                ss << " [" << begin << ", " << end << ")";
+            }
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct AtEof : public ReassemblerExpectation {
     AtEof() {}
     std::string description() const {
@@ -137,6 +210,28 @@ struct NotAtEof : public ReassemblerExpectation {
     }
 };
 
+struct PathCounts : public ReassemblerExpectation {
+    uint64_t _fast;
+    uint64_t _slow;
+
+    PathCounts(uint64_t fast, uint64_t slow) : _fast(fast), _slow(slow) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "fast path pushes = " << _fast << ", slow path pushes = " << _slow;
+        return ss.str();
+    }
+
+    void execute(StreamReassembler &reassembler) const {
+        if (reassembler.fast_path_pushes() != _fast or reassembler.slow_path_pushes() != _slow) {
+            std::ostringstream ss;
+            ss << "The reassembler was expected to have taken the fast path `" << _fast << "` times and the slow path `"
+               << _slow << "` times, but the counts were `" << reassembler.fast_path_pushes() << "` and `"
+               << reassembler.slow_path_pushes() << "`";
+            throw ReassemblerExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct SubmitSegment : public ReassemblerAction {
     std::string _data;
     size_t _index;
@@ -164,10 +259,18 @@ class ReassemblerTestHarness {
     std::vector<std::string> steps_executed;
 
   public:
-    ReassemblerTestHarness(const size_t capacity) : reassembler(capacity), steps_executed() {
+    ReassemblerTestHarness(const size_t capacity)
+        : reassembler(capacity, StreamReassembler::Backend::REASSEMBLER_BACKEND), steps_executed() {
         steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) + ")");
     }
 
+    ReassemblerTestHarness(const size_t capacity, ReassemblyBudget *budget, const size_t unassembled_limit)
+        : reassembler(capacity, StreamReassembler::Backend::REASSEMBLER_BACKEND, budget, unassembled_limit)
+        , steps_executed() {
+        steps_executed.emplace_back("Initialized (capacity = " + std::to_string(capacity) +
+                                    ", unassembled_limit = " + std::to_string(unassembled_limit) + ")");
+    }
+
     void execute(const ReassemblerTestStep &step) {
         try {
             step.execute(reassembler);
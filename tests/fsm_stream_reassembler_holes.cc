@@ -131,6 +131,24 @@ int main() {
             test.execute(BytesAvailable(""));
             test.execute(AtEof{});
         }
+        {
+            ReassemblerTestHarness test{65000};
+
+            test.execute(UnassembledRanges{{}});
+            test.execute(SubmitSegment{"cd", 2});
+            test.execute(SubmitSegment{"gh", 6});
+            test.execute(UnassembledRanges{{{2, 4}, {6, 8}}});
+
+            // adjacent and overlapping substrings join their neighbours
+            test.execute(SubmitSegment{"ef", 4});
+            test.execute(SubmitSegment{"hij", 7});
+            test.execute(SubmitSegment{"xyz", 100});
+            test.execute(UnassembledRanges{{{2, 10}, {100, 103}}});
+
+            test.execute(SubmitSegment{"ab", 0});
+            test.execute(BytesAssembled(10));
+            test.execute(UnassembledRanges{{{100, 103}}});
+        }
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
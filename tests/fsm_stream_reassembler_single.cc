@@ -1,6 +1,7 @@
 #include "byte_stream.hh"
 #include "fsm_stream_reassembler_harness.hh"
 #include "stream_reassembler.hh"
+#include "test_err_if.hh"
 #include "util.hh"
 
 #include <exception>
@@ -136,6 +137,14 @@ int main() {
             test.execute(BytesAvailable("abcde"));
             test.execute(AtEof{});
         }
+
+        // a string literal can be pushed directly
+        {
+            StreamReassembler reassembler{8};
+            reassembler.push_substring("cd", 2, true);
+            reassembler.push_substring("ab", 0, false);
+            test_err_if(reassembler.stream_out().read(4) != "abcd", "a pushed C string was reassembled wrong");
+        }
     } catch (const exception &e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
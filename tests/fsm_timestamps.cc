@@ -0,0 +1,181 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+//! \returns whether the segment carries the timestamps (value, echo_reply)
+static bool has_timestamps(const TCPSegment &seg, const uint32_t value, const uint32_t echo_reply) {
+    return seg.header().timestamps == TCPHeader::Timestamps{value, echo_reply};
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.timestamps = true;
+
+        // test 1: active open with timestamps, echoing, and PAWS (with the peer's clock about to wrap)
+        {
+            const WrappingInt32 rx_isn(rd());
+            const uint32_t peer_clock = 0xffff'ff00;
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Tick(5));
+            test_1.execute(Connect{});
+            const TCPSegment syn = test_1.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(false));
+            test_err_if(not has_timestamps(syn, 5, 0),
+                        "test 1 failed: SYN without our clock: " + syn.header().summary());
+            const WrappingInt32 tx_isn = syn.header().seqno;
+
+            test_1.execute(Tick(20));
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_timestamps(peer_clock, 5));
+            TCPSegment ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1));
+            test_err_if(not has_timestamps(ack, 25, peer_clock),
+                        "test 1 failed: ACK doesn't echo the SYN's timestamp: " + ack.header().summary());
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            // a timestamp past the wrap is newer
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(rx_isn + 1)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_timestamps(0x10, 25)
+                               .with_data("a"));
+            ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2));
+            test_err_if(not has_timestamps(ack, 25, 0x10), "test 1 failed: wrong echo: " + ack.header().summary());
+            test_1.execute(ExpectData{}.with_data("a"));
+
+            // PAWS: an older timestamp means an old duplicate; it's acknowledged but not accepted
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(rx_isn + 2)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_timestamps(peer_clock + 0x80, 25)
+                               .with_data("b"));
+            ack = test_1.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2));
+            test_err_if(not has_timestamps(ack, 25, 0x10), "test 1 failed: wrong echo: " + ack.header().summary());
+            test_1.execute(ExpectNoData{}, "test 1 failed: segment with an old timestamp accepted");
+
+            // once negotiated, a segment without timestamps is dropped silently
+            test_1.execute(SendSegment{}
+                               .with_ack(true)
+                               .with_seqno(rx_isn + 2)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_data("c"));
+            test_1.execute(ExpectNoSegment{});
+            test_1.execute(ExpectNoData{}, "test 1 failed: segment without timestamps accepted");
+
+            // our data carries the current clock
+            test_1.execute(Tick(10));
+            test_1.execute(Write{"d"});
+            const TCPSegment data = test_1.expect_seg(ExpectOneSegment{}.with_data("d"));
+            test_err_if(not has_timestamps(data, 35, 0x10),
+                        "test 1 failed: wrong timestamps: " + data.header().summary());
+        }
+
+        // test 2: passive open, the peer doesn't use timestamps -> neither do we
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.send_syn(rx_isn);
+            const TCPSegment syn_ack =
+                test_2.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1));
+            test_err_if(syn_ack.header().timestamps.has_value(), "test 2 failed: timestamps on the SYN-ACK");
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+
+            test_2.send_ack(rx_isn + 1, tx_isn + 1);
+            test_2.send_byte(rx_isn + 1, tx_isn + 1, 'a');
+            const TCPSegment ack = test_2.expect_seg(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 2));
+            test_err_if(ack.header().timestamps.has_value(), "test 2 failed: timestamps on the ACK");
+        }
+
+        // test 3: passive open with timestamps -> the SYN-ACK echoes the SYN's clock
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Listen{});
+            test_3.execute(Tick(7));
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_timestamps(1234, 0));
+            const TCPSegment syn_ack =
+                test_3.expect_seg(ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1));
+            test_err_if(not has_timestamps(syn_ack, 7, 1234),
+                        "test 3 failed: SYN-ACK doesn't echo the SYN: " + syn_ack.header().summary());
+        }
+
+        // test 4: the option survives serialization alongside window scale and SACK
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().window_scale = 7;
+            seg.header().timestamps = TCPHeader::Timestamps{0x1234'5678, 0x9abc'def0};
+            seg.header().sack_permitted = true;
+            TCPSegment parsed;
+            test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError,
+                        "test 4 failed: SYN with options didn't parse");
+            test_err_if(not(parsed.header().timestamps == seg.header().timestamps) or
+                            parsed.header().window_scale != 7 or not parsed.header().sack_permitted,
+                        "test 4 failed: options lost: " + parsed.header().summary());
+
+            TCPSegment data;
+            data.header().ack = true;
+            data.header().timestamps = TCPHeader::Timestamps{1, 2};
+            for (uint32_t i = 0; i < 4; ++i) {
+                data.header().sack.push_back({WrappingInt32{100 * i}, WrappingInt32{100 * i + 50}});
+            }
+            data.payload() = string("payload");
+            test_err_if(parsed.parse(data.serialize().concatenate()) != ParseResult::NoError,
+                        "test 4 failed: segment with options didn't parse");
+            // the timestamps take twelve bytes, leaving room for three blocks
+            test_err_if(not(parsed.header().timestamps == data.header().timestamps) or
+                            parsed.header().sack.size() != 3 or parsed.payload().copy() != "payload",
+                        "test 4 failed: options lost: " + parsed.header().summary());
+        }
+
+        // test 5: once negotiated, the timestamps take room from every segment's payload
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_5(cfg);
+            test_5.execute(Connect{});
+            const WrappingInt32 tx_isn = test_5.expect_seg(ExpectOneSegment{}.with_syn(true)).header().seqno;
+            test_5.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(10000)
+                               .with_timestamps(1, 0));
+            test_5.execute(ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_payload_size(0));
+
+            test_5.execute(Write{string(TCPConfig::MAX_PAYLOAD_SIZE, 'x')});
+            test_5.execute(ExpectSegment{}.with_payload_size(TCPConfig::MAX_PAYLOAD_SIZE - 12),
+                           "test 5 failed: a full segment has no room for its timestamps");
+            test_5.execute(ExpectOneSegment{}.with_payload_size(12));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
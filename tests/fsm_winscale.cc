@@ -0,0 +1,136 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr size_t CAPACITY = 1 << 20;  // needs a shift of 5 to fit in 16 bits
+static constexpr uint8_t CAPACITY_SHIFT = 5;
+static constexpr uint16_t MAX_WIN = numeric_limits<uint16_t>::max();
+
+//! Write more than the window allows, and check that exactly `window` bytes are sent
+static void check_send_window(TCPTestHarness &test, const size_t window) {
+    test.execute(Write{string(2 * window, 'x')});
+    test.execute(Tick(1));
+    size_t bytes_sent = 0;
+    while (test.can_read()) {
+        bytes_sent += test.expect_seg(ExpectSegment{}.with_ack(true)).payload().size();
+    }
+    test_err_if(bytes_sent != window,
+                "sent " + to_string(bytes_sent) + " bytes into a " + to_string(window) + " byte window");
+    test.execute(ExpectBytesInFlight{window});
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        TCPConfig cfg{};
+        cfg.recv_capacity = CAPACITY;
+        cfg.send_capacity = CAPACITY;
+        cfg.window_scaling = true;
+
+        // test 1: active open, the peer scales too -> windows both ways are scaled after the SYNs
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_1(cfg);
+            test_1.execute(Connect{});
+            const TCPSegment syn = test_1.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(false).with_win(MAX_WIN), "test 1 failed: no SYN");
+            test_err_if(syn.header().window_scale != CAPACITY_SHIFT, "test 1 failed: wrong window scale on SYN");
+            const WrappingInt32 tx_isn = syn.header().seqno;
+
+            // the window on the SYN-ACK isn't scaled
+            test_1.execute(SendSegment{}
+                               .with_syn(true)
+                               .with_ack(true)
+                               .with_seqno(rx_isn)
+                               .with_ackno(tx_isn + 1)
+                               .with_win(1000)
+                               .with_window_scale(3));
+            test_1.execute(
+                ExpectOneSegment{}.with_ack(true).with_ackno(rx_isn + 1).with_win(CAPACITY >> CAPACITY_SHIFT),
+                "test 1 failed: advertised window not scaled");
+            test_1.execute(ExpectState{State::ESTABLISHED});
+
+            test_1.send_ack(rx_isn + 1, tx_isn + 1, 1000);
+            check_send_window(test_1, 1000 << 3);
+        }
+
+        // test 2: passive open, the peer doesn't offer to scale -> no option on the SYN-ACK, and no scaling
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_2(cfg);
+            test_2.execute(Listen{});
+            test_2.send_syn(rx_isn);
+            const TCPSegment syn_ack = test_2.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1).with_win(MAX_WIN),
+                "test 2 failed: no SYN-ACK");
+            test_err_if(syn_ack.header().window_scale.has_value(), "test 2 failed: window scale on SYN-ACK");
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+
+            test_2.send_ack(rx_isn + 1, tx_isn + 1, 1000);
+            test_2.execute(ExpectState{State::ESTABLISHED});
+            test_2.execute(ExpectNoSegment{});
+            check_send_window(test_2, 1000);
+            test_2.send_byte(rx_isn + 1, tx_isn + 1 + 1000, 'y');
+            test_2.execute(ExpectSegment{}.with_ack(true).with_ackno(rx_isn + 2).with_win(MAX_WIN),
+                           "test 2 failed: window was scaled");
+        }
+
+        // test 3: passive open, both offer to scale -> the SYN-ACK carries our shift
+        {
+            const WrappingInt32 rx_isn(rd());
+            TCPTestHarness test_3(cfg);
+            test_3.execute(Listen{});
+            test_3.execute(SendSegment{}.with_syn(true).with_seqno(rx_isn).with_win(1000).with_window_scale(0));
+            const TCPSegment syn_ack = test_3.expect_seg(
+                ExpectOneSegment{}.with_syn(true).with_ack(true).with_ackno(rx_isn + 1).with_win(MAX_WIN),
+                "test 3 failed: no SYN-ACK");
+            test_err_if(syn_ack.header().window_scale != CAPACITY_SHIFT,
+                        "test 3 failed: wrong window scale on SYN-ACK");
+            const WrappingInt32 tx_isn = syn_ack.header().seqno;
+
+            test_3.send_ack(rx_isn + 1, tx_isn + 1, 1000);
+            check_send_window(test_3, 1000);
+            test_3.send_byte(rx_isn + 1, tx_isn + 1 + 1000, 'y');
+            test_3.execute(
+                ExpectSegment{}.with_ack(true).with_ackno(rx_isn + 2).with_win((CAPACITY - 1) >> CAPACITY_SHIFT),
+                "test 3 failed: advertised window not scaled");
+        }
+
+        // test 4: the option survives serialization alongside SACK-permitted and SACK blocks
+        {
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().window_scale = 7;
+            seg.header().sack_permitted = true;
+            for (uint32_t i = 0; i < 4; ++i) {
+                seg.header().sack.push_back({WrappingInt32{100 * i}, WrappingInt32{100 * i + 50}});
+            }
+            TCPSegment parsed;
+            test_err_if(parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError,
+                        "test 4 failed: segment with options didn't parse");
+            test_err_if(parsed.header().window_scale != 7 or not parsed.header().sack_permitted,
+                        "test 4 failed: options lost: " + parsed.header().summary());
+            // the window scale option takes four bytes, leaving room for three blocks
+            test_err_if(parsed.header().sack.size() != 3, "test 4 failed: wrong number of SACK blocks");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}
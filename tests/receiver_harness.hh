@@ -13,6 +13,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -100,6 +101,33 @@ struct ExpectUnassembledBytes : public ReceiverExpectation {
     }
 };
 
+struct ExpectSackBlocks : public ReceiverExpectation {
+    std::vector<TCPHeader::SackBlock> _blocks;
+
+    ExpectSackBlocks(std::vector<TCPHeader::SackBlock> blocks) : _blocks(std::move(blocks)) {}
+    std::string description() const {
+        std::ostringstream ss;
+        ss << _blocks.size() << " SACK blocks:";
+        for (const auto &block : _blocks) {
+            ss << " " << block.left << "-" << block.right;
+        }
+        return ss.str();
+    }
+
+    void execute(TCPReceiver &receiver) const {
+        const auto actual = receiver.sack_blocks();
+        if (actual != _blocks) {
+            std::ostringstream ss;
+            ss << "The TCPReceiver reported the SACK blocks";
+            for (const auto &block : actual) {
+                ss << " " << block.left << "-" << block.right;
+            }
+            ss << ", but " << description() << " were expected";
+            throw ReceiverExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectTotalAssembledBytes : public ReceiverExpectation {
     size_t _n_bytes;
 
@@ -293,6 +321,11 @@ struct SegmentArrives : public ReceiverAction {
     }
 };
 
+struct WindowAdvertised : public ReceiverAction {
+    std::string description() const { return "window advertised"; }
+    void execute(TCPReceiver &receiver) const { receiver.advertise_window(); }
+};
+
 class TCPReceiverTestHarness {
     TCPReceiver receiver;
     std::vector<std::string> steps_executed;
@@ -304,6 +337,17 @@ class TCPReceiverTestHarness {
            << "capacity=" << capacity << ")";
         steps_executed.emplace_back(ss.str());
     }
+    TCPReceiverTestHarness(size_t capacity,
+                           ReassemblyBudget *budget,
+                           size_t unassembled_limit,
+                           ReassemblyBudget::Policy policy)
+        : receiver(capacity, budget, unassembled_limit, policy), steps_executed() {
+        std::ostringstream ss;
+        ss << "Initialized with ("
+           << "capacity=" << capacity << ", unassembled_limit=" << unassembled_limit << ", policy="
+           << (policy == ReassemblyBudget::Policy::ShrinkWindow ? "ShrinkWindow" : "DropNewest") << ")";
+        steps_executed.emplace_back(ss.str());
+    }
     void execute(const ReceiverTestStep &step) {
         try {
             step.execute(receiver);
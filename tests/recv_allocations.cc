@@ -0,0 +1,95 @@
+#include "buffer.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! Every allocation in this program, counted by the replaced operator new
+static size_t allocations = 0;
+
+void *operator new(const size_t size) {
+    ++allocations;
+    if (void *p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, const size_t) noexcept { free(p); }
+
+//! A segment carrying `data` at `seqno`
+static TCPSegment data_segment(const WrappingInt32 seqno, const string &data) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.payload() = Buffer{string(data)};
+    return seg;
+}
+
+//! \returns the allocations made while `seg` was received
+static size_t allocations_receiving(TCPReceiver &receiver, const TCPSegment &seg) {
+    const size_t before = allocations;
+    receiver.segment_received(seg);
+    return allocations - before;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        constexpr size_t cap = 4096;
+        constexpr size_t size = 1000;
+        const WrappingInt32 isn(rd());
+
+        TCPReceiver receiver{cap};
+        TCPSegment syn;
+        syn.header().syn = true;
+        syn.header().seqno = isn;
+        receiver.segment_received(syn);
+
+        // the segments are made up front, so that only the receiver's own allocations are counted
+        vector<TCPSegment> segments;
+        for (size_t i = 0; i < 8; ++i) {
+            segments.push_back(data_segment(isn + 1 + i * size, string(size, char('a' + i))));
+        }
+
+        // the first segments grow the stream's storage; after that, in-order data costs no allocation
+        receiver.segment_received(segments[0]);
+        receiver.segment_received(segments[1]);
+        receiver.stream_out().pop_output(2 * size);
+        for (size_t i = 2; i < 4; ++i) {
+            const size_t count = allocations_receiving(receiver, segments[i]);
+            if (count != 0) {
+                throw runtime_error("an in-order segment cost " + to_string(count) + " allocations");
+            }
+        }
+        receiver.stream_out().pop_output(2 * size);
+
+        // an out-of-order segment costs one allocation (its node in the reassembler), not a copy of its payload
+        const size_t count = allocations_receiving(receiver, segments[5]);
+        if (count != 1) {
+            throw runtime_error("an out-of-order segment cost " + to_string(count) + " allocations");
+        }
+        if (allocations_receiving(receiver, segments[4]) != 0) {
+            throw runtime_error("filling the gap allocated");
+        }
+        if (receiver.stream_out().read(2 * size) != string(size, 'e') + string(size, 'f')) {
+            throw runtime_error("wrong bytes reassembled");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
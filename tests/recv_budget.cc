@@ -0,0 +1,130 @@
+#include "receiver_harness.hh"
+#include "reassembly_budget.hh"
+#include "tcp_config.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        {
+            // DropNewest: out-of-order bytes beyond the limit are dropped, but the window is unaffected
+            size_t cap = 4000;
+            uint32_t isn = 23452;
+            TCPReceiverTestHarness test{cap, nullptr, 4, ReassemblyBudget::Policy::DropNewest};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectWindow{cap});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 5).with_data("efghij").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectUnassembledBytes{4});
+            test.execute(ExpectWindow{cap});
+            test.execute(
+                SegmentArrives{}.with_seqno(isn + 1).with_data("abcd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectAckno{WrappingInt32{isn + 9}});
+            test.execute(ExpectUnassembledBytes{0});
+            test.execute(ExpectBytes{"abcdefgh"});
+        }
+
+        {
+            // ShrinkWindow: the window is limited to what can be held out of order
+            size_t cap = 8 * MSS;
+            uint32_t isn = 23452;
+            TCPReceiverTestHarness test{cap, nullptr, 2 * MSS, ReassemblyBudget::Policy::ShrinkWindow};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectWindow{2 * MSS});
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 1 + MSS)
+                             .with_data(string(MSS, 'b'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectUnassembledBytes{MSS});
+            test.execute(ExpectWindow{2 * MSS});
+            test.execute(SegmentArrives{}
+                             .with_seqno(isn + 1)
+                             .with_data(string(MSS, 'a'))
+                             .with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectAckno{WrappingInt32{isn + 1 + uint32_t(2 * MSS)}});
+            test.execute(ExpectWindow{2 * MSS});
+        }
+
+        {
+            // ShrinkWindow with a shared budget: one receiver's held bytes shrink the other's window, though
+            // never below one segment
+            size_t cap = 8 * MSS;
+            uint32_t isn = 23452;
+            ReassemblyBudget budget{3 * MSS};
+            TCPReceiverTestHarness first{cap, &budget, cap, ReassemblyBudget::Policy::ShrinkWindow};
+            TCPReceiverTestHarness second{cap, &budget, cap, ReassemblyBudget::Policy::ShrinkWindow};
+            first.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            second.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            first.execute(ExpectWindow{3 * MSS});
+            first.execute(SegmentArrives{}
+                              .with_seqno(isn + 1 + MSS)
+                              .with_data(string(MSS + MSS / 2, 'b'))
+                              .with_result(SegmentArrives::Result::OK));
+            first.execute(ExpectWindow{3 * MSS});
+            second.execute(ExpectWindow{MSS + MSS / 2});
+            first.execute(SegmentArrives{}
+                              .with_seqno(isn + 1)
+                              .with_data(string(MSS, 'a'))
+                              .with_result(SegmentArrives::Result::OK));
+            first.execute(ExpectBytes{string(MSS, 'a') + string(MSS + MSS / 2, 'b')});
+            second.execute(ExpectWindow{3 * MSS});
+        }
+
+        {
+            // ShrinkWindow with the shared budget used up by another receiver: in-order data still has a
+            // segment's room, and the window already advertised isn't taken back
+            size_t cap = 8 * MSS;
+            uint32_t isn = 23452;
+            ReassemblyBudget budget{2 * MSS};
+            TCPReceiverTestHarness first{cap, &budget, cap, ReassemblyBudget::Policy::ShrinkWindow};
+            TCPReceiverTestHarness second{cap, &budget, cap, ReassemblyBudget::Policy::ShrinkWindow};
+            first.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            second.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            second.execute(ExpectWindow{2 * MSS});
+            second.execute(WindowAdvertised{});
+            first.execute(SegmentArrives{}
+                              .with_seqno(isn + 2)
+                              .with_data(string(2 * MSS, 'x'))
+                              .with_result(SegmentArrives::Result::OK));
+            first.execute(ExpectUnassembledBytes{2 * MSS});
+            first.execute(ExpectWindow{2 * MSS});
+
+            // (advertised before the budget ran out)
+            second.execute(ExpectWindow{2 * MSS});
+            second.execute(SegmentArrives{}
+                               .with_seqno(isn + 1)
+                               .with_data(string(MSS + MSS / 2, 'a'))
+                               .with_result(SegmentArrives::Result::OK));
+            second.execute(ExpectWindow{MSS});
+            second.execute(SegmentArrives{}
+                               .with_seqno(isn + 1 + uint32_t(MSS + MSS / 2))
+                               .with_data(string(MSS, 'b'))
+                               .with_result(SegmentArrives::Result::OK));
+            second.execute(ExpectBytes{string(MSS + MSS / 2, 'a') + string(MSS, 'b')});
+            second.execute(ExpectWindow{MSS});
+
+            // (out-of-order bytes can't be held, though)
+            second.execute(SegmentArrives{}
+                               .with_seqno(isn + 2 + uint32_t(2 * MSS + MSS / 2))
+                               .with_data("c")
+                               .with_result(SegmentArrives::Result::OK));
+            second.execute(ExpectUnassembledBytes{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
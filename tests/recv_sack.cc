@@ -0,0 +1,90 @@
+#include "receiver_harness.hh"
+#include "tcp_header.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // the block with the latest segment comes first, the rest in sequence order
+            size_t cap = 4000;
+            uint32_t isn = 23452;
+            TCPReceiverTestHarness test{cap};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 3).with_data("cd").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 3}, WrappingInt32{isn + 5}}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 9).with_data("ij").with_result(SegmentArrives::Result::OK));
+            test.execute(SegmentArrives{}.with_seqno(isn + 7).with_data("g").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 7}, WrappingInt32{isn + 8}},
+                                           {WrappingInt32{isn + 3}, WrappingInt32{isn + 5}},
+                                           {WrappingInt32{isn + 9}, WrappingInt32{isn + 11}}}});
+
+            // filling a gap merges two blocks
+            test.execute(SegmentArrives{}.with_seqno(isn + 8).with_data("h").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 7}, WrappingInt32{isn + 11}},
+                                           {WrappingInt32{isn + 3}, WrappingInt32{isn + 5}}}});
+
+            // in-order data leaves only what's still beyond a hole
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("ab").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectAckno{WrappingInt32{isn + 5}});
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 7}, WrappingInt32{isn + 11}}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 5).with_data("ef").with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(ExpectBytes{"abcdefghij"});
+        }
+
+        {
+            // SACK options survive serialization, as many blocks as fit after SACK-permitted
+            TCPHeader header;
+            header.syn = true;
+            header.sack_permitted = true;
+            for (uint32_t i = 0; i < 5; ++i) {
+                header.sack.push_back({WrappingInt32{1000 + 100 * i}, WrappingInt32{1050 + 100 * i}});
+            }
+            TCPSegment seg;
+            seg.header() = header;
+            seg.payload() = string("payload");
+
+            TCPSegment parsed;
+            if (parsed.parse(seg.serialize().concatenate()) != ParseResult::NoError) {
+                throw runtime_error("a segment with SACK options did not parse");
+            }
+            if (parsed.header().doff != 15 or not parsed.header().sack_permitted or
+                parsed.payload().copy() != "payload") {
+                throw runtime_error("SACK options were not serialized as expected: " + parsed.header().summary());
+            }
+            header.sack.erase(header.sack.begin() + 4, header.sack.end());
+            if (parsed.header().sack != header.sack) {
+                throw runtime_error("SACK blocks did not survive serialization: " + parsed.header().summary());
+            }
+
+            // an unknown option before them is skipped
+            string raw = seg.serialize().concatenate();
+            raw[20] = 99;  // replace the first NOP NOP with an unknown two-byte option
+            raw[21] = 2;
+            raw[16] = raw[17] = 0;
+            InternetChecksum check;
+            check.add(raw);
+            raw[16] = check.value() >> 8;
+            raw[17] = check.value() & 0xff;
+            if (parsed.parse(move(raw)) != ParseResult::NoError or not parsed.header().sack_permitted) {
+                throw runtime_error("an unknown option confused the parser");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
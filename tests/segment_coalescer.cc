@@ -0,0 +1,115 @@
+#include "segment_coalescer.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! A data segment from one flow, acknowledging `ackno`
+static TCPSegment data_segment(const WrappingInt32 seqno, const string &data, const WrappingInt32 ackno) {
+    TCPSegment seg;
+    seg.header().sport = 1234;
+    seg.header().dport = 5678;
+    seg.header().ack = true;
+    seg.header().ackno = ackno;
+    seg.header().win = 1000;
+    seg.header().seqno = seqno;
+    seg.payload() = Buffer{string(data)};
+    return seg;
+}
+
+//! Everything the coalescer has let out
+static vector<CoalescedSegment> drain(SegmentCoalescer &coalescer) {
+    vector<CoalescedSegment> ret;
+    while (not coalescer.segments_out().empty()) {
+        ret.push_back(move(coalescer.segments_out().front()));
+        coalescer.segments_out().pop();
+    }
+    return ret;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: a run of in-order segments becomes one, which ends as the last one does
+        {
+            const WrappingInt32 isn(rd()), ackno(rd());
+            SegmentCoalescer coalescer;
+            coalescer.push(data_segment(isn, "abc", ackno));
+            TCPSegment second = data_segment(isn + 3, "def", ackno);
+            const char *const second_data = second.payload().str().data();
+            coalescer.push(move(second));
+            TCPSegment last = data_segment(isn + 6, "ghi", ackno);
+            last.header().fin = true;
+            coalescer.push(move(last));
+            test_err_if(not coalescer.segments_out().empty(), "test 1 failed: a run was let out before the flush");
+            coalescer.flush();
+
+            const auto out = drain(coalescer);
+            test_err_if(out.size() != 1, "test 1 failed: run not merged into one segment");
+            test_err_if(out[0].segment.header().seqno != isn or out[0].payload() != "abcdefghi",
+                        "test 1 failed: merged segment has the wrong data");
+            test_err_if(not out[0].segment.header().fin or out[0].segment.header().ackno != ackno,
+                        "test 1 failed: merged segment has the wrong header");
+            test_err_if(out[0].more_payload.size() != 2 or out[0].more_payload[0].str().data() != second_data,
+                        "test 1 failed: payloads copied rather than kept as they arrived");
+            test_err_if(coalescer.merged() != 2, "test 1 failed: merges not counted");
+        }
+
+        // test 2: anything that doesn't continue the run starts a new one, and the order is kept
+        {
+            const WrappingInt32 isn(rd()), ackno(rd());
+            SegmentCoalescer coalescer;
+            coalescer.push(data_segment(isn, "ab", ackno));
+            coalescer.push(data_segment(isn + 4, "ef", ackno));  // out of order
+            coalescer.push(data_segment(isn + 2, "cd", ackno));  // fills the gap, but arrived later
+            coalescer.push(data_segment(isn + 4, "ef", ackno + 1));  // in order, but acknowledges more
+            TCPSegment push = data_segment(isn + 6, "gh", ackno + 1);
+            push.header().psh = true;
+            coalescer.push(move(push));
+            coalescer.push(data_segment(isn + 8, "ij", ackno + 1));  // after a PSH
+            TCPSegment empty = data_segment(isn + 10, "", ackno + 1);
+            coalescer.push(move(empty));
+            coalescer.flush();
+
+            const auto out = drain(coalescer);
+            const vector<string> payloads{"ab", "ef", "cd", "efgh", "ij", ""};
+            test_err_if(out.size() != payloads.size(), "test 2 failed: " + to_string(out.size()) + " segments let out");
+            for (size_t i = 0; i < out.size(); ++i) {
+                test_err_if(out[i].payload() != payloads[i],
+                            "test 2 failed: segment " + to_string(i) + " is \"" + out[i].payload() + "\", not \"" +
+                                payloads[i] + "\"");
+            }
+            test_err_if(not out[3].segment.header().psh, "test 2 failed: PSH lost");
+        }
+
+        // test 3: a merged segment is no bigger than a super-segment
+        {
+            const WrappingInt32 isn(rd()), ackno(rd());
+            const string full(TCPConfig::MAX_PAYLOAD_SIZE, 'x');
+            const size_t count = TCPConfig::MAX_OFFLOAD_PAYLOAD / full.size() + 1;
+            SegmentCoalescer coalescer;
+            for (size_t i = 0; i < count; ++i) {
+                coalescer.push(data_segment(isn + i * full.size(), full, ackno));
+            }
+            coalescer.flush();
+            const auto out = drain(coalescer);
+            test_err_if(out.size() != 2 or out[0].payload().size() != TCPConfig::MAX_OFFLOAD_PAYLOAD,
+                        "test 3 failed: merged segment has the wrong size");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include "buffer.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+static void check(const bool condition, const string &what) {
+    if (not condition) {
+        throw runtime_error(what);
+    }
+}
+
+//! Hand every segment `from` has sent to `to`, the way an adapter would: by moving it out of the queue
+static void move_segments(TCPConnection &from, TCPConnection &to) {
+    while (not from.segments_out().empty()) {
+        const TCPSegment seg = move(from.segments_out().front());
+        from.segments_out().pop();
+        to.segment_received(seg);
+    }
+}
+
+// These checks only see who owns a payload at the moment they look (its use_count()): they catch a copy that
+// is kept, but not one made and dropped again along the way.
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // serializing shares the payload, unless the segment is no longer needed
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.payload() = Buffer{string(100, 'x')};
+            const BufferList shared = seg.serialize();
+            check(seg.payload().use_count() == 2, "serializing a segment didn't share its payload once");
+            const BufferList moved = move(seg).serialize();
+            check(moved.buffers().back().use_count() == 2,
+                  "serializing a segment that's no longer needed left it a share of its payload");
+            check(moved.concatenate() == shared.concatenate(), "serializing by moving gave different bytes");
+        }
+
+        // in a bulk transfer, a data segment's payload is shared by the segment and the sender (in case it has to
+        // be resent), and by nothing else on its way between the two ends
+        {
+            TCPConfig cfg;
+            TCPConnection x{cfg}, y{cfg};
+            x.connect();
+            move_segments(x, y);
+            move_segments(y, x);
+            move_segments(x, y);
+
+            const string data(TCPConfig::MAX_PAYLOAD_SIZE, 'y');
+            for (size_t round = 0; round < 100; ++round) {
+                x.write(data);
+                check(x.segments_out().size() == 1, "write didn't send one segment");
+                Buffer payload;
+                {
+                    TCPSegment seg = move(x.segments_out().front());
+                    x.segments_out().pop();
+                    check(seg.payload().use_count() == 2,
+                          "a data segment's payload has " + to_string(seg.payload().use_count()) + " owners, not 2");
+                    payload = seg.payload();
+                    y.segment_received(seg);
+                }
+
+                // once it's been received and acknowledged, nothing but this test holds the payload
+                move_segments(y, x);
+                check(y.inbound_stream().read(data.size()) == data, "wrong bytes received");
+                check(payload.use_count() == 1, "a payload is still held after it was acknowledged");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
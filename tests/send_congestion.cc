@@ -0,0 +1,267 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Acknowledge everything the sender has sent so far
+struct AckAllSent : public SenderAction {
+    uint16_t _win;
+
+    AckAllSent(uint16_t win) : _win(win) {}
+    string description() const { return "ack everything sent, winsize " + to_string(_win); }
+
+    void execute(TCPSender &sender, queue<TCPSegment> &) const {
+        sender.ack_received(sender.next_seqno(), _win);
+        sender.fill_window();
+    }
+};
+
+struct ExpectBbrMode : public SenderExpectation {
+    Bbr::Mode _mode;
+
+    ExpectBbrMode(Bbr::Mode mode) : _mode(mode) {}
+    string description() const { return "BBR mode " + to_string(static_cast<int>(_mode)); }
+
+    void execute(TCPSender &sender, queue<TCPSegment> &) const {
+        const auto *bbr = dynamic_cast<const Bbr *>(sender.congestion_control());
+        if (bbr == nullptr) {
+            throw SenderExpectationViolation("The TCPSender isn't using BBR");
+        }
+        if (bbr->mode() != _mode) {
+            throw SenderExpectationViolation("BBR was in mode " + to_string(static_cast<int>(bbr->mode())) +
+                                             ", but it was expected to be in mode " +
+                                             to_string(static_cast<int>(_mode)));
+        }
+    }
+};
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        const size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+        const size_t IW = NewReno::INITIAL_WINDOW_SEGMENTS * MSS;
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"NewReno: initial window and slow start", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{IW});
+            test.execute(WriteBytes{string(20 * MSS, 'x')});
+            for (size_t i = 0; i < NewReno::INITIAL_WINDOW_SEGMENTS; ++i) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{IW});
+
+            // an ack for two segments grows the window by two segments, so four more go out
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{IW + 2 * MSS});
+            for (size_t i = 0; i < 4; ++i) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{IW + 2 * MSS});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"NewReno: timeout, slow start and congestion avoidance", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10 * MSS, 'x')});
+            for (size_t i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            }
+
+            // a timeout collapses the window to one segment and halves the threshold
+            test.execute(Tick{cfg.rt_timeout - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(5 * MSS));
+
+            // the window (two segments) is still full
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2 * MSS});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{4 * MSS});
+
+            test.execute(WriteBytes{string(10 * MSS, 'x')});
+            for (size_t i = 0; i < 4; ++i) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // slow start overshoots the threshold...
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 14 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{6 * MSS});
+            for (size_t i = 0; i < 6; ++i) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // ...and then congestion avoidance adds one segment per window acknowledged
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 17 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{6 * MSS});
+            test.execute(WriteBytes{string(10 * MSS, 'x')});
+            for (size_t i = 0; i < 3; ++i) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 23 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{7 * MSS}.with_ssthresh(5 * MSS));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"NewReno: the receiver's window still applies", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(2000));
+            test.execute(WriteBytes{string(10 * MSS, 'x')});
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            test.execute(ExpectSegment{}.with_no_flags().with_payload_size(2000 - MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 60000;
+            cfg.send_capacity = 100 * MSS;
+            cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC: HyStart ends slow start when the RTT rises", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(100 * MSS, 'x')});
+            test.execute(ExpectBytesInFlight{IW});
+
+            // the first round: each ack (10 ms after its segment was sent) grows the window by a segment
+            test.execute(Tick{10});
+            for (size_t i = 1; i <= 10; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + uint32_t(i * MSS)}}.with_win(60000));
+            }
+            test.execute(ExpectCongestionWindow{20 * MSS});
+            test.execute(ExpectBytesInFlight{20 * MSS});
+
+            // the second round: the RTT has doubled, so the eighth sample ends slow start
+            test.execute(Tick{20});
+            for (size_t i = 11; i <= 17; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + uint32_t(i * MSS)}}.with_win(60000));
+            }
+            test.execute(ExpectCongestionWindow{27 * MSS});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 18 * MSS}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{27 * MSS}.with_ssthresh(27 * MSS));
+
+            // five seconds on, the cubic curve is well above the window, so each ack grows it by half a segment
+            test.execute(Tick{5000});
+            for (size_t i = 19; i <= 30; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + uint32_t(i * MSS)}}.with_win(60000));
+            }
+            test.execute(ExpectCongestionWindow{33 * MSS}.with_ssthresh(27 * MSS));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC: a timeout reduces the threshold by BETA", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(10 * MSS, 'x')});
+            test.execute(ExpectBytesInFlight{IW});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(7 * MSS));
+
+            // later timeouts in the same series leave the threshold alone
+            test.execute(Tick{2u * cfg.rt_timeout});
+            test.execute(ExpectCongestionWindow{MSS}.with_ssthresh(7 * MSS));
+        }
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 60000;
+            cfg.send_capacity = 100 * MSS;
+            cfg.congestion_control = CongestionControl::Algorithm::Bbr;
+
+            TCPSenderTestHarness test{"BBR: Startup measures the bandwidth and paces above it", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(100 * MSS, 'x')});
+            test.execute(ExpectBytesInFlight{IW});
+            for (size_t i = 0; i < NewReno::INITIAL_WINDOW_SEGMENTS; ++i) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            }
+
+            // the window was delivered in 10 ms: 1452 bytes/ms, which Startup paces at HIGH_GAIN times
+            test.execute(Tick{10});
+            for (size_t i = 1; i <= 10; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1 + uint32_t(i * MSS)}}.with_win(60000));
+            }
+            test.execute(ExpectBbrMode{Bbr::Mode::Startup});
+            test.execute(ExpectPacingRate{Bbr::HIGH_GAIN * IW * 1000 / 10});
+            test.execute(ExpectCongestionWindow{2 * IW});
+
+            // the window has room, but pacing holds the segments back until the clock earns them
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            for (size_t i = 0; i < 3; ++i) {
+                test.execute(ExpectSegment{}.with_no_flags().with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = 60000;
+            cfg.send_capacity = 2000 * MSS;
+            cfg.congestion_control = CongestionControl::Algorithm::Bbr;
+
+            TCPSenderTestHarness test{"BBR: a flat bandwidth ends Startup, then ProbeBW paces at it", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(2000 * MSS, 'x')});
+
+            // the receiver's window caps delivery at 60000 bytes per 10 ms round
+            for (size_t round = 0; round < 8; ++round) {
+                test.execute(Tick{10});
+                test.execute(AckAllSent{60000});
+            }
+            test.execute(ExpectBbrMode{Bbr::Mode::ProbeBW});
+            test.execute(ExpectPacingRate{60000 * 1000 / 10});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static void check(const bool condition, const string &what) {
+    if (not condition) {
+        throw runtime_error(what);
+    }
+}
+
+//! Take the one segment `sender` has sent
+static TCPSegment sent_segment(TCPSender &sender) {
+    check(sender.segments_out().size() == 1, "expected one segment, found " + to_string(sender.segments_out().size()));
+    TCPSegment seg = move(sender.segments_out().front());
+    sender.segments_out().pop();
+    return seg;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // splitting a super-segment: a header for each piece, and the payload's storage shared
+        {
+            const WrappingInt32 isn(rd());
+            string data(2 * MSS + 100, 0);
+            for (auto &ch : data) {
+                ch = rd();
+            }
+            TCPSegment seg;
+            seg.header().seqno = isn;
+            seg.header().syn = seg.header().fin = seg.header().psh = seg.header().ack = true;
+            seg.header().ackno = WrappingInt32(rd());
+            seg.header().win = 1234;
+            seg.header().timestamps = TCPHeader::Timestamps{uint32_t(rd()), uint32_t(rd())};
+            seg.payload() = Buffer{string(data)};
+
+            const auto pieces = seg.split(MSS);
+            check(pieces.size() == 3, "super-segment split into " + to_string(pieces.size()) + " pieces");
+            const size_t sizes[] = {MSS, MSS, 100};
+            const WrappingInt32 seqnos[] = {isn, isn + 1 + MSS, isn + 1 + 2 * MSS};
+            for (size_t i = 0; i < pieces.size(); ++i) {
+                const TCPHeader &header = pieces[i].header();
+                check(header.seqno == seqnos[i], "piece " + to_string(i) + " has the wrong seqno");
+                check(header.syn == (i == 0), "SYN on the wrong piece");
+                check(header.fin == (i == 2) and header.psh == (i == 2), "FIN or PSH on the wrong piece");
+                check(header.ack and header.ackno == seg.header().ackno and header.win == 1234 and
+                          header.timestamps == seg.header().timestamps,
+                      "piece " + to_string(i) + " doesn't have the super-segment's header");
+                check(pieces[i].payload().size() == sizes[i], "piece " + to_string(i) + " has the wrong size");
+                check(pieces[i].payload().str().data() == seg.payload().str().data() + i * MSS,
+                      "piece " + to_string(i) + " doesn't share the super-segment's storage");
+
+                // each piece goes on the wire with its own checksum
+                TCPSegment parsed;
+                check(parsed.parse(pieces[i].serialize().concatenate()) == ParseResult::NoError,
+                      "piece " + to_string(i) + " doesn't parse");
+                check(parsed.header().seqno == seqnos[i] and parsed.payload().str() == data.substr(i * MSS, sizes[i]),
+                      "piece " + to_string(i) + " parsed wrong");
+            }
+
+            // a segment that isn't too big is only copied
+            check(pieces[2].split(MSS).size() == 1, "small segment split");
+        }
+
+        // the sender sends super-segments, but resends no more than a wire segment at a time
+        {
+            TCPConfig cfg;
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.segmentation_offload = true;
+            cfg.send_capacity = 2 * TCPConfig::MAX_OFFLOAD_PAYLOAD;
+
+            TCPSender sender{cfg};
+            sender.fill_window();
+            check(sent_segment(sender).header().syn, "no SYN");
+            sender.ack_received(isn + 1, 60 * MSS);
+            sender.stream_in().write(string(60 * MSS, 'x'));
+            sender.fill_window();
+            check(sender.segments_out().size() == 2, "window not sent as super-segments");
+            check(sender.segments_out().front().payload().size() == TCPConfig::MAX_OFFLOAD_PAYLOAD,
+                  "first super-segment isn't as big as allowed");
+            sender.segments_out().pop();
+            check(sender.segments_out().front().payload().size() == 60 * MSS - TCPConfig::MAX_OFFLOAD_PAYLOAD,
+                  "second super-segment doesn't fill the window");
+            sender.segments_out().pop();
+
+            sender.tick(cfg.rt_timeout);
+            TCPSegment resent = sent_segment(sender);
+            check(resent.header().seqno == isn + 1 and resent.payload().size() == MSS,
+                  "timeout didn't resend the first wire segment alone");
+
+            // an ack inside a super-segment acknowledges its head
+            sender.ack_received(isn + 1 + 3 * MSS, 60 * MSS);
+            check(sender.bytes_in_flight() == 57 * MSS, "partial ack of a super-segment not counted");
+            sender.tick(cfg.rt_timeout);
+            resent = sent_segment(sender);
+            check(resent.header().seqno == isn + 1 + 3 * MSS and resent.payload().size() == MSS,
+                  "timeout after a partial ack didn't resend the next wire segment");
+        }
+
+        // without segmentation offload (or when paced), segments are wire-sized
+        for (const bool paced : {false, true}) {
+            TCPConfig cfg;
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.segmentation_offload = paced;
+            cfg.pacing_rate = paced ? 100 * MSS * 1000 : 0;
+
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sent_segment(sender);
+            sender.ack_received(isn + 1, 10 * MSS);
+            sender.tick(10);
+            sender.stream_in().write(string(10 * MSS, 'y'));
+            sender.fill_window();
+            check(sender.segments_out().size() == 10, "segments aren't wire-sized");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
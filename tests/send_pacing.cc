@@ -0,0 +1,89 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.send_capacity = 100 * MSS;
+            cfg.pacing_rate = MSS * 1000;  // a segment per millisecond
+            cfg.pacing_burst = 2 * MSS;
+
+            TCPSenderTestHarness test{"Fixed-rate pacing releases a segment per millisecond", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+
+            // the bucket starts empty, so the window waits for the clock
+            test.execute(WriteBytes{string(20 * MSS, 'x')});
+            test.execute(ExpectNoSegment{});
+            for (size_t i = 0; i < 3; ++i) {
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+                test.execute(ExpectNoSegment{});
+            }
+
+            // a coarse tick earns its whole worth, even beyond the burst allowance
+            test.execute(Tick{10});
+            for (size_t i = 0; i < 10; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // an idle sender saves up no more than the burst allowance
+            test.execute(Tick{1});
+            for (size_t i = 0; i < 7; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+                test.execute(Tick{1});
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + uint32_t(20 * MSS)}}.with_win(60000));
+            for (size_t i = 0; i < 10; ++i) {
+                test.execute(Tick{1});
+            }
+            test.execute(WriteBytes{string(5 * MSS, 'y')});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_data(string(MSS, 'y')));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_data(string(MSS, 'y')));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(MSS));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing_rate = MSS * 1000;
+            cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+            TCPSenderTestHarness test{"The congestion window still limits a paced sender", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(20 * MSS, 'x')});
+            test.execute(Tick{100});
+            for (size_t i = 0; i < NewReno::INITIAL_WINDOW_SEGMENTS; ++i) {
+                test.execute(ExpectSegment{}.with_payload_size(MSS));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -105,6 +105,34 @@ int main() {
             test.execute(Tick{1}.with_max_retx_exceeded(true));
         }
 
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            // a retransmission is rebuilt from the scoreboard, with the very payload storage first sent
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1, 1000);
+            sender.stream_in().write("abcd");
+            sender.stream_in().end_input();
+            sender.fill_window();
+            const TCPSegment sent = sender.segments_out().front();
+            sender.segments_out().pop();
+            sender.tick(cfg.rt_timeout);
+            if (sender.segments_out().size() != 1) {
+                throw runtime_error("segment with FIN not retransmitted");
+            }
+            const TCPSegment &resent = sender.segments_out().front();
+            if (resent.header().seqno != isn + 1 or not resent.header().fin or resent.header().syn) {
+                throw runtime_error("retransmission has the wrong header");
+            }
+            if (resent.payload().str().data() != sent.payload().str().data() or resent.payload().size() != 4) {
+                throw runtime_error("retransmission doesn't share the payload sent");
+            }
+        }
+
     } catch (const exception &e) {
         cerr << e.what() << endl;
         return 1;
@@ -0,0 +1,135 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 1;
+
+            TCPSenderTestHarness test{"Adaptive RTO follows SRTT and RTTVAR", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRto{cfg.rt_timeout});
+
+            // first sample: SRTT = R, RTTVAR = R/2, RTO = SRTT + 4 * RTTVAR
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRto{120}.with_srtt(40));
+
+            // second sample: RTTVAR = 3/4 * 20 + 1/4 * |40 - 20|, SRTT = 7/8 * 40 + 1/8 * 20
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc"));
+            test.execute(Tick{20});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(ExpectRto{118}.with_srtt(37.5));
+
+            // the estimate times out the next segment, and the timeout backs off as usual
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("def"));
+            test.execute(Tick{117});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("def"));
+            test.execute(ExpectRto{236});
+
+            // Karn's rule: the retransmitted segment's ack gives no sample, but ends the backoff
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 7}}.with_win(1000));
+            test.execute(ExpectRto{118}.with_srtt(37.5));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"Adaptive RTO on a fast path stops at the minimum", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{2});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRto{cfg.rto_min}.with_srtt(2));
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc"));
+            test.execute(Tick{cfg.rto_min - 1});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rt_timeout = 300;
+            cfg.rto_max = 1000;
+
+            TCPSenderTestHarness test{"Adaptive RTO backs off no further than the maximum", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{300});
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRto{600});
+            test.execute(Tick{600});
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRto{1000});
+            test.execute(Tick{1000});
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRto{1000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 1;
+
+            TCPSenderTestHarness test{"A measured RTT (from timestamps) is used even for a retransmission", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_measured_rtt(40));
+            test.execute(ExpectRto{120}.with_srtt(40));
+
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc"));
+            test.execute(Tick{120});
+            test.execute(ExpectSegment{}.with_payload_size(3).with_data("abc"));
+
+            // RTTVAR = 3/4 * 20 + 1/4 * |40 - 10|, SRTT = 7/8 * 40 + 1/8 * 10
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000).with_measured_rtt(10));
+            test.execute(ExpectRto{127}.with_srtt(36.25));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Fixed RTO still measures SRTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{40});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(ExpectRto{cfg.rt_timeout}.with_srtt(40));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
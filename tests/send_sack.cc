@@ -0,0 +1,105 @@
+#include "sender_harness.hh"
+#include "tcp_header.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! Ten bytes for each of the segments sent
+static string chunk(const size_t i) { return string(10, char('a' + i)); }
+
+//! The block covering segments [first, last] of the ten-byte segments after the SYN
+static TCPHeader::SackBlock segments(const WrappingInt32 isn, const uint32_t first, const uint32_t last) {
+    return {isn + 1 + 10 * first, isn + 1 + 10 * (last + 1)};
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (const bool sack : {true, false}) {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{sack ? "SACK retransmits every hole on the third duplicate ack"
+                                           : "Without SACK, the second hole waits for a partial ack",
+                                      cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            for (size_t i = 0; i < 6; ++i) {
+                test.execute(WriteBytes{chunk(i)});
+                test.execute(ExpectSegment{}.with_payload_size(10).with_data(chunk(i)));
+            }
+
+            // segments 0 and 2 are lost; the receiver reports the others as they arrive
+            const vector<vector<TCPHeader::SackBlock>> dup_acks{
+                {segments(isn, 1, 1)},
+                {segments(isn, 3, 3), segments(isn, 1, 1)},
+                {segments(isn, 3, 4), segments(isn, 1, 1)},
+            };
+            for (const auto &blocks : dup_acks) {
+                test.execute(ExpectNoSegment{});
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(
+                    sack ? blocks : vector<TCPHeader::SackBlock>{}));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(10).with_data(chunk(0)));
+            if (sack) {
+                test.execute(ExpectSegment{}.with_payload_size(10).with_data(chunk(2)));
+            }
+            test.execute(ExpectNoSegment{});
+
+            // another duplicate ack doesn't resend anything that has been resent, or that arrived since
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack(
+                sack ? vector<TCPHeader::SackBlock>{segments(isn, 3, 5), segments(isn, 1, 1)}
+                     : vector<TCPHeader::SackBlock>{}));
+            test.execute(ExpectNoSegment{});
+
+            // the first retransmission arrives: the partial ack is for the start of segment 2
+            test.execute(AckReceived{WrappingInt32{isn + 21}}.with_win(1000).with_sack(
+                sack ? vector<TCPHeader::SackBlock>{segments(isn, 3, 5)} : vector<TCPHeader::SackBlock>{}));
+            if (not sack) {
+                test.execute(ExpectSegment{}.with_payload_size(10).with_data(chunk(2)));
+            }
+            test.execute(ExpectNoSegment{});
+
+            test.execute(AckReceived{WrappingInt32{isn + 61}}.with_win(1000));
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"SACK blocks outside the window are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            for (size_t i = 0; i < 3; ++i) {
+                test.execute(WriteBytes{chunk(i)});
+                test.execute(ExpectSegment{}.with_payload_size(10).with_data(chunk(i)));
+            }
+
+            // a block beyond what was sent claims nothing, so only the first segment is a hole
+            for (size_t i = 0; i < 3; ++i) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000).with_sack({segments(isn, 2, 9)}));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(10).with_data(chunk(0)));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -9,12 +9,14 @@
 #include "wrapping_integers.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <deque>
 #include <exception>
 #include <iostream>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -99,6 +101,109 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectCongestionWindow : public SenderExpectation {
+    size_t _cwnd;
+    std::optional<size_t> _ssthresh{};
+
+    ExpectCongestionWindow(size_t cwnd) : _cwnd(cwnd) {}
+
+    ExpectCongestionWindow &with_ssthresh(size_t ssthresh) {
+        _ssthresh = ssthresh;
+        return *this;
+    }
+
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "congestion window " << _cwnd;
+        if (_ssthresh.has_value()) {
+            ss << ", slow-start threshold " << _ssthresh.value();
+        }
+        return ss.str();
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        const CongestionControl *cc = sender.congestion_control();
+        if (cc == nullptr) {
+            throw SenderExpectationViolation("The TCPSender has no congestion control");
+        }
+        if (cc->cwnd() != _cwnd) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a congestion window of " << cc->cwnd() << ", but it was expected to be "
+               << _cwnd;
+            throw SenderExpectationViolation(ss.str());
+        }
+        if (_ssthresh.has_value() and cc->ssthresh() != _ssthresh.value()) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a slow-start threshold of " << cc->ssthresh()
+               << ", but it was expected to be " << _ssthresh.value();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectPacingRate : public SenderExpectation {
+    double _rate;
+
+    //! \param rate bytes per second, expected to within 1%
+    ExpectPacingRate(double rate) : _rate(rate) {}
+    std::string description() const { return "pacing rate " + std::to_string(_rate) + " bytes/s"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        const CongestionControl *cc = sender.congestion_control();
+        if (cc == nullptr) {
+            throw SenderExpectationViolation("The TCPSender has no congestion control");
+        }
+        if (std::abs(cc->pacing_rate() - _rate) > _rate / 100) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a pacing rate of " << cc->pacing_rate()
+               << " bytes/s, but it was expected to be " << _rate;
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
+struct ExpectRto : public SenderExpectation {
+    unsigned int _rto;
+    std::optional<double> _srtt{};
+
+    ExpectRto(unsigned int rto) : _rto(rto) {}
+
+    ExpectRto &with_srtt(double srtt) {
+        _srtt = srtt;
+        return *this;
+    }
+
+    std::string description() const {
+        std::ostringstream ss;
+        ss << "retransmission timeout " << _rto << " ms";
+        if (_srtt.has_value()) {
+            ss << ", smoothed RTT " << _srtt.value() << " ms";
+        }
+        return ss.str();
+    }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.rto_ms() != _rto) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a retransmission timeout of " << sender.rto_ms()
+               << " ms, but it was expected to be " << _rto;
+            throw SenderExpectationViolation(ss.str());
+        }
+        if (_srtt.has_value() and
+            (not sender.srtt_ms().has_value() or std::abs(sender.srtt_ms().value() - _srtt.value()) > 1e-6)) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a smoothed RTT of ";
+            if (sender.srtt_ms().has_value()) {
+                ss << sender.srtt_ms().value();
+            } else {
+                ss << "(none)";
+            }
+            ss << " ms, but it was expected to be " << _srtt.value();
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -191,11 +296,19 @@ struct Tick : public SenderAction {
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
     std::optional<uint16_t> _window_advertisement{};
+    std::vector<TCPHeader::SackBlock> _sack{};
+    std::optional<uint64_t> _measured_rtt{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (const auto &block : _sack) {
+            ss << " sack " << block.left.raw_value() << "-" << block.right.raw_value();
+        }
+        if (_measured_rtt.has_value()) {
+            ss << " measured rtt " << _measured_rtt.value();
+        }
         return ss.str();
     }
 
@@ -204,8 +317,18 @@ struct AckReceived : public SenderAction {
         return *this;
     }
 
+    AckReceived &with_sack(std::vector<TCPHeader::SackBlock> sack) {
+        _sack = std::move(sack);
+        return *this;
+    }
+
+    AckReceived &with_measured_rtt(uint64_t rtt) {
+        _measured_rtt = rtt;
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
-        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW), true, _sack, _measured_rtt);
         sender.fill_window();
     }
 };
@@ -394,7 +517,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
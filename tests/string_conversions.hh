@@ -14,6 +14,8 @@ using std::to_string;
 
 std::string to_string(WrappingInt32 i) { return std::to_string(i.raw_value()); }
 
+std::string to_string(const std::string &s) { return "\"" + s + "\""; }
+
 template <typename T>
 std::string to_string(const std::optional<T> &v) {
     if (v.has_value()) {
@@ -4,6 +4,7 @@
 #include "tcp_config.hh"
 #include "tcp_expectation_forward.hh"
 #include "tcp_fsm_test_harness.hh"
+#include "tcp_header.hh"
 #include "tcp_state.hh"
 
 #include <algorithm>
@@ -11,6 +12,7 @@
 #include <exception>
 #include <optional>
 #include <sstream>
+#include <vector>
 
 struct TCPExpectation : public TCPTestStep {
     virtual ~TCPExpectation() {}
@@ -257,6 +259,12 @@ struct ExpectSegment : public TCPExpectation {
                                               std::to_string(seg.length_in_sequence_space()) +
                                               ") greater than the maximum");
         }
+        const size_t options_length = seg.header().doff * 4u - TCPHeader::LENGTH;
+        if (options_length + seg.payload().size() > TCPConfig::MAX_PAYLOAD_SIZE) {
+            throw SegmentExpectationViolation("packet has options and payload (" + std::to_string(options_length) +
+                                              " + " + std::to_string(seg.payload().size()) +
+                                              " bytes) greater than the maximum");
+        }
         if (data.has_value() and seg.payload().str() != *data) {
             throw SegmentExpectationViolation("payloads differ");
         }
@@ -382,6 +390,29 @@ struct ExpectLingerTimer : public TCPExpectation {
     }
 };
 
+struct ExpectRetransmissions : public TCPExpectation {
+    size_t fast;
+    size_t timeout;
+
+    ExpectRetransmissions(size_t fast_, size_t timeout_) : fast(fast_), timeout(timeout_) {}
+
+    std::string description() const {
+        std::ostringstream o;
+        o << "TCP has made " << fast << " fast and " << timeout << " timeout retransmissions";
+        return o.str();
+    }
+
+    void execute(TCPTestHarness &harness) const {
+        if (harness._fsm.fast_retransmissions() != fast) {
+            throw TCPPropertyViolation::make("fast_retransmissions", fast, harness._fsm.fast_retransmissions());
+        }
+        if (harness._fsm.timeout_retransmissions() != timeout) {
+            throw TCPPropertyViolation::make(
+                "timeout_retransmissions", timeout, harness._fsm.timeout_retransmissions());
+        }
+    }
+};
+
 struct SendSegment : public TCPAction {
     bool ack{false};
     bool rst{false};
@@ -392,6 +423,10 @@ struct SendSegment : public TCPAction {
     uint16_t win{0};
     size_t payload_size{0};
     std::string data{};
+    std::optional<uint8_t> window_scale{};
+    std::optional<TCPHeader::Timestamps> timestamps{};
+    bool sack_permitted{false};
+    std::vector<TCPHeader::SackBlock> sack{};
 
     SendSegment() {}
 
@@ -404,6 +439,10 @@ struct SendSegment : public TCPAction {
         ackno = seg.header().ackno;
         win = seg.header().win;
         data = seg.payload();
+        window_scale = seg.header().window_scale;
+        timestamps = seg.header().timestamps;
+        sack_permitted = seg.header().sack_permitted;
+        sack = seg.header().sack;
     }
 
     SendSegment &with_ack(bool ack_) {
@@ -455,6 +494,21 @@ struct SendSegment : public TCPAction {
         return *this;
     }
 
+    SendSegment &with_window_scale(uint8_t window_scale_) {
+        window_scale = window_scale_;
+        return *this;
+    }
+
+    SendSegment &with_timestamps(uint32_t value, uint32_t echo_reply) {
+        timestamps = TCPHeader::Timestamps{value, echo_reply};
+        return *this;
+    }
+
+    SendSegment &with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
     TCPSegment get_segment() const {
         TCPSegment data_seg;
         data_seg.payload() = std::string(data);
@@ -466,6 +520,10 @@ struct SendSegment : public TCPAction {
         data_hdr.ackno = ackno;
         data_hdr.seqno = seqno;
         data_hdr.win = win;
+        data_hdr.window_scale = window_scale;
+        data_hdr.timestamps = timestamps;
+        data_hdr.sack_permitted = sack_permitted;
+        data_hdr.sack = sack;
         return data_seg;
     }
 
@@ -564,4 +622,14 @@ struct Close : public TCPAction {
     void execute(TCPTestHarness &harness) const { harness._fsm.end_input_stream(); }
 };
 
+struct Cork : public TCPAction {
+    std::string description() const { return "cork"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.cork(); }
+};
+
+struct Uncork : public TCPAction {
+    std::string description() const { return "uncork"; }
+    void execute(TCPTestHarness &harness) const { harness._fsm.uncork(); }
+};
+
 #endif  // SPONGE_LIBSPONGE_TCP_EXPECTATION_HH
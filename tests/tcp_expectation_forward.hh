@@ -37,6 +37,8 @@ struct Tick;
 struct Connect;
 struct Listen;
 struct Close;
+struct Cork;
+struct Uncork;
 
 class TCPExpectationViolation : public std::runtime_error {
   public:
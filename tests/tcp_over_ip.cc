@@ -0,0 +1,75 @@
+#include "address.hh"
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+//! Wrap `seg` in an IPv4 datagram from `from`, put it on the wire, and unwrap it at `to`
+static optional<TCPSegment> send_over_ip(TCPOverIPv4Adapter &from, TCPOverIPv4Adapter &to, TCPSegment seg) {
+    const InternetDatagram sent = from.wrap_tcp_in_ip(move(seg));
+    InternetDatagram received;
+    test_err_if(received.parse(sent.serialize().concatenate()) != ParseResult::NoError,
+                "datagram carrying a TCP segment doesn't parse");
+    return to.unwrap_tcp_in_ip(received);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        TCPOverIPv4Adapter a, b;
+        a.config_mut().source = b.config_mut().destination = Address{"10.0.0.1", 1000};
+        a.config_mut().destination = b.config_mut().source = Address{"10.0.0.2", 2000};
+
+        // a segment with every option: the IPv4 length has to count the options the header grows to fit
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.header().syn = seg.header().ack = seg.header().sack_permitted = true;
+            seg.header().ackno = WrappingInt32(rd());
+            seg.header().window_scale = 7;
+            seg.header().timestamps = TCPHeader::Timestamps{uint32_t(rd()), uint32_t(rd())};
+            seg.header().sack = {{WrappingInt32(100), WrappingInt32(200)}, {WrappingInt32(300), WrappingInt32(400)}};
+            seg.payload() = Buffer{string("hello")};
+            const TCPHeader sent = seg.header();
+
+            const auto received = send_over_ip(a, b, move(seg));
+            test_err_if(not received.has_value(), "segment with options not unwrapped");
+            const TCPHeader &header = received->header();
+            test_err_if(header.doff != sent.data_offset() or header.doff * 4u <= TCPHeader::LENGTH,
+                        "segment with options has the wrong data offset");
+            const bool same = header.seqno == sent.seqno and header.ackno == sent.ackno and header.syn and
+                              header.window_scale == sent.window_scale and header.timestamps == sent.timestamps and
+                              header.sack_permitted and header.sack == sent.sack;
+            test_err_if(not same, "segment with options unwrapped with the wrong header");
+            test_err_if(received->payload().str() != "hello", "segment with options unwrapped with the wrong payload");
+        }
+
+        // and without options
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.payload() = Buffer{string("world")};
+            const auto received = send_over_ip(b, a, move(seg));
+            test_err_if(not received.has_value() or received->header().doff != TCPHeader::LENGTH / 4 or
+                            received->payload().str() != "world",
+                        "segment without options unwrapped wrong");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "test_err_if.hh"
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! \returns a string for an optional timeout, for error messages
+static string describe(const optional<uint64_t> timeout) {
+    return timeout.has_value() ? to_string(timeout.value()) : "none";
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: timers at every level (and beyond the wheel's span) fire exactly at their deadlines, in order
+        {
+            const uint64_t start = uniform_int_distribution<uint64_t>{0, uint64_t{1} << 40}(rd);
+            TimerWheel wheel{start};
+            vector<uint64_t> deadlines;
+            for (const uint64_t span : {uint64_t{64}, uint64_t{4096}, uint64_t{1} << 18, uint64_t{1} << 25}) {
+                for (size_t i = 0; i < 200; ++i) {
+                    deadlines.push_back(start + uniform_int_distribution<uint64_t>{0, span}(rd));
+                }
+            }
+
+            size_t fired = 0;
+            uint64_t last_fired = start;
+            for (const uint64_t deadline : deadlines) {
+                wheel.schedule(deadline, [&, deadline] {
+                    const uint64_t due = max(deadline, start + 1);
+                    test_err_if(wheel.now() != due,
+                                "test 1 failed: timer for " + to_string(due) + " fired at " + to_string(wheel.now()));
+                    test_err_if(wheel.now() < last_fired, "test 1 failed: timers fired out of order");
+                    last_fired = wheel.now();
+                    ++fired;
+                });
+            }
+            test_err_if(wheel.size() != deadlines.size(), "test 1 failed: wrong number of timers scheduled");
+
+            // advance by uneven steps, sometimes by many milliseconds at once
+            while (wheel.size() > 0) {
+                wheel.tick(uniform_int_distribution<uint64_t>{1, 5000}(rd));
+            }
+            test_err_if(fired != deadlines.size(), "test 1 failed: not every timer fired");
+        }
+
+        // test 2: cancelled and rescheduled timers, stale identifiers, and callbacks that schedule timers
+        {
+            TimerWheel wheel{1000};
+            vector<uint64_t> fired;
+            const auto record = [&] { fired.push_back(wheel.now()); };
+
+            const auto cancelled = wheel.schedule(1010, record);
+            const auto moved = wheel.schedule(1020, record);
+            wheel.schedule(1500, record);
+            wheel.cancel(cancelled);
+            test_err_if(not wheel.reschedule(moved, 1005), "test 2 failed: couldn't reschedule");
+            test_err_if(wheel.size() != 2, "test 2 failed: wrong number of timers scheduled");
+
+            wheel.advance_to(1100);
+            test_err_if(fired != vector<uint64_t>{1005}, "test 2 failed: wrong timers fired");
+            test_err_if(wheel.reschedule(moved, 1200), "test 2 failed: rescheduled a timer that had fired");
+            wheel.cancel(moved);  // does nothing, not even to a timer that reused its storage
+            test_err_if(wheel.size() != 1, "test 2 failed: stale identifier cancelled a timer");
+
+            // a periodic timer, and a timer scheduled in the past (which fires on the next millisecond)
+            size_t periods = 0;
+            function<void()> periodic = [&] {
+                if (++periods < 10) {
+                    wheel.schedule(wheel.now() + 100, periodic);
+                }
+            };
+            wheel.schedule(1150, periodic);
+            wheel.schedule(900, record);
+            wheel.advance_to(1101);
+            test_err_if((fired != vector<uint64_t>{1005, 1101}), "test 2 failed: past deadline didn't fire next");
+            wheel.advance_to(3000);
+            test_err_if(periods != 10, "test 2 failed: periodic timer ran " + to_string(periods) + " times");
+            test_err_if((fired != vector<uint64_t>{1005, 1101, 1500}), "test 2 failed: wrong timers fired");
+            test_err_if(wheel.size() != 0, "test 2 failed: timers left over");
+
+            // an empty wheel jumps straight to the new time
+            wheel.advance_to(uint64_t{1} << 50);
+            test_err_if(wheel.now() != uint64_t{1} << 50, "test 2 failed: empty wheel didn't advance");
+        }
+
+        // test 3: a connection's next timeout follows its retransmission timer
+        {
+            TCPConfig cfg{};
+            TCPConnection conn{cfg};
+            test_err_if(conn.next_timeout().has_value(),
+                        "test 3 failed: idle connection has a timeout: " + describe(conn.next_timeout()));
+            conn.connect();
+            test_err_if(conn.next_timeout() != optional<uint64_t>{cfg.rt_timeout},
+                        "test 3 failed: SYN sent, timeout is " + describe(conn.next_timeout()));
+            conn.tick(cfg.rt_timeout / 4);
+            test_err_if(conn.next_timeout() != optional<uint64_t>{cfg.rt_timeout - cfg.rt_timeout / 4},
+                        "test 3 failed: timeout didn't count down: " + describe(conn.next_timeout()));
+
+            // a late tick covering the whole timeout retransmits, and backs off
+            conn.tick(10 * cfg.rt_timeout);
+            test_err_if(conn.segments_out().size() != 2, "test 3 failed: SYN not retransmitted");
+            test_err_if(conn.next_timeout() != optional<uint64_t>{2 * cfg.rt_timeout},
+                        "test 3 failed: timeout didn't back off: " + describe(conn.next_timeout()));
+        }
+
+        // test 4: advancing to far-off deadlines skips the empty milliseconds (stepping through the 2^36 of
+        // them one by one would take minutes)
+        {
+            const uint64_t start = uniform_int_distribution<uint64_t>{0, uint64_t{1} << 40}(rd);
+            TimerWheel wheel{start};
+            vector<uint64_t> fired;
+            const auto record = [&] { fired.push_back(wheel.now()); };
+            const vector<uint64_t> deadlines{start + 3, start + (uint64_t{1} << 30) + 17, start + (uint64_t{1} << 36)};
+            for (const uint64_t deadline : deadlines) {
+                wheel.schedule(deadline, record);
+            }
+
+            const auto began = chrono::steady_clock::now();
+            wheel.advance_to(start + (uint64_t{1} << 36) - 1);
+            test_err_if((fired != vector<uint64_t>{deadlines[0], deadlines[1]}), "test 4 failed: wrong timers fired");
+            wheel.advance_to(start + (uint64_t{1} << 37));
+            test_err_if(fired != deadlines, "test 4 failed: far-off timer didn't fire at its deadline");
+            test_err_if(wheel.now() != start + (uint64_t{1} << 37), "test 4 failed: wheel didn't advance");
+            test_err_if(chrono::steady_clock::now() - began > chrono::seconds{1},
+                        "test 4 failed: advancing to far-off deadlines was slow");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return err_num;
+    }
+
+    return EXIT_SUCCESS;
+}